@@ -4,20 +4,33 @@
 #include "esp_attr.h"
 #include "esp_log.h"
 #include "sdkconfig.h"
+#include "esp_spi_flash.h"
 
 typedef esp_err_t (* coredump_to_server_start_t)(void *priv);
 typedef esp_err_t (* coredump_to_server_end_t)(void * priv);
 typedef esp_err_t (* coredump_to_server_write_t)(void *priv, char const * const str);
 
+#define COREDUMP_LINE_LEN   48      // bytes per base64 line (64 characters)
+#ifndef COREDUMP_CHUNK_LEN
+#define COREDUMP_CHUNK_LEN  3072    // default bytes per flash read and write() call
+#endif
+
 typedef struct coredump_to_server_config_t {
     coredump_to_server_start_t  start;  // this function is called before writin data chunks (e.g. to open connection to srv)
     coredump_to_server_end_t    end;    // this function is called when all dump data are written (e.g. to close connection to srv)
-    coredump_to_server_write_t  write;  // this function is called to write data chunk
+    coredump_to_server_write_t  write;  // this function is called to write data chunk, one or more "\r\n" terminated base64 lines
     void *                      priv;   // pointer to data specific to requester
+    size_t                      chunk_len;  // bytes read per write() call, multiple of COREDUMP_LINE_LEN, 0 for COREDUMP_CHUNK_LEN
 } coredump_to_server_config_t;
 
 esp_err_t coredump_to_server(coredump_to_server_config_t const * const cfg);
 
+// maps the raw dump (as stored in the coredump partition) read only into the
+// data address space, release with coredump_unmap()
+esp_err_t coredump_mmap(const void **data, size_t *size, spi_flash_mmap_handle_t *handle);
+
+void coredump_unmap(spi_flash_mmap_handle_t handle);
+
 esp_err_t clear_coredump();
 
 bool coredump_available();
\ No newline at end of file
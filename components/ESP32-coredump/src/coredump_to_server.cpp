@@ -15,11 +15,13 @@ extern "C" {
 #include <esp_flash.h>
 #include <esp_log.h>
 #include <esp_spi_flash.h>
+#include <esp_partition.h>
 #include <mbedtls/base64.h>
 
 #include "coredump_to_server.h"
 
 #define MIN(a,b) ({ __typeof__ (a) _a = (a); __typeof__ (b) _b = (b); _a < _b ? _a : _b; })
+#define MAX(a,b) ({ __typeof__ (a) _a = (a); __typeof__ (b) _b = (b); _a > _b ? _a : _b; })
 static char const * const  TAG = "coredump";
 
 // from https://github.com/espressif/esp-idf/blob/cf056a7d0b90261923b8207f21dc270313b67456/components/espcoredump/src/core_dump_uart.c
@@ -59,36 +61,44 @@ esp_err_t coredump_to_server(coredump_to_server_config_t const * const write_cfg
         ESP_LOGI(TAG, "No coredump in flash");
         return err;
     }
-    size_t const chunk_len = 3 * 16;  // must be multiple of 3
-    size_t const b64_len = chunk_len / 3 * 4 + 4;
+    // a whole chunk is read with one flash access and encoded into one
+    // buffer of COREDUMP_LINE_LEN lines, so the writer sends it at once
+    size_t chunk_len = write_cfg->chunk_len ? write_cfg->chunk_len : COREDUMP_CHUNK_LEN;
+    chunk_len = MAX(COREDUMP_LINE_LEN, chunk_len / COREDUMP_LINE_LEN * COREDUMP_LINE_LEN);
+    size_t const line_len = COREDUMP_LINE_LEN / 3 * 4 + 2;
+    size_t const b64_len = chunk_len / COREDUMP_LINE_LEN * line_len + 4;
     uint8_t * const chunk = (uint8_t *)malloc(chunk_len);
     char * const b64 = (char *)malloc(b64_len);
-    assert(chunk && b64);
+    if (!chunk || !b64) {
+        free(chunk);
+        free(b64);
+        return ESP_ERR_NO_MEM;
+    }
 
     if (write_cfg->start) {
         if ((err = write_cfg->start(write_cfg->priv)) != ESP_OK) {
+            free(chunk);
+            free(b64);
             return err;
         }
     }
 
-    // ESP_LOGI(TAG, "Coredump is %u bytes", coredump_size);
+    ESP_LOGI(TAG, "Coredump is %u bytes, %u per chunk", coredump_size, chunk_len);
     for (size_t offset = 0; offset < coredump_size; offset += chunk_len) {
 
         uint const read_len = MIN(chunk_len, coredump_size - offset);
-        if (esp_flash_read(esp_flash_default_chip, chunk, coredump_addr + offset , read_len)) {
+        if ((err = esp_flash_read(esp_flash_default_chip, chunk, coredump_addr + offset , read_len)) != ESP_OK) {
             ESP_LOGE(TAG, "Coredump read failed");
             break;
         }
-#if 1
-        esp_core_dump_b64_encode(chunk, read_len, (uint8_t *)b64);
-#else
-        size_t olen;
-        if (mbedtls_base64_encode(b64, b64_len, &olen, chunk, read_len) != 0) {
-            ESP_LOGE(TAG, "Coredump b64 failed");
-            break;
+        size_t pos = 0;
+        for (uint line = 0; line < read_len; line += COREDUMP_LINE_LEN) {
+            esp_core_dump_b64_encode(chunk + line, MIN(COREDUMP_LINE_LEN, read_len - line), (uint8_t *)b64 + pos);
+            pos += strlen(b64 + pos);
+            b64[pos++] = '\r';
+            b64[pos++] = '\n';
         }
-#endif
-        //ets_printf("%s\r\n", b64);
+        b64[pos] = 0;
         if (write_cfg->write) {
             if ((err = write_cfg->write(write_cfg->priv, b64)) != ESP_OK) {
                 break;
@@ -99,13 +109,42 @@ esp_err_t coredump_to_server(coredump_to_server_config_t const * const write_cfg
     free(b64);
 
     if (write_cfg->end) {
-        if ((err = write_cfg->end(write_cfg->priv)) != ESP_OK) {
-            return err;
+        esp_err_t end_err = write_cfg->end(write_cfg->priv);
+        if (err == ESP_OK) {
+            err = end_err;
         }
     }
     return err;
 }
 
+esp_err_t coredump_mmap(const void **data, size_t *size, spi_flash_mmap_handle_t *handle)
+{
+    size_t coredump_addr;
+    size_t coredump_size;
+    esp_err_t err = esp_core_dump_image_get(&coredump_addr, &coredump_size);
+    if (err != ESP_OK) {
+        ESP_LOGI(TAG, "No coredump in flash");
+        return err;
+    }
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_COREDUMP, NULL);
+    if (!part || coredump_addr < part->address) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    // esp_partition_mmap() takes care of the MMU page alignment
+    err = esp_partition_mmap(part, coredump_addr - part->address, coredump_size, SPI_FLASH_MMAP_DATA, data, handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Coredump mmap failed (%d)", err);
+        return err;
+    }
+    *size = coredump_size;
+    return ESP_OK;
+}
+
+void coredump_unmap(spi_flash_mmap_handle_t handle)
+{
+    spi_flash_munmap(handle);
+}
+
 esp_err_t clear_coredump(){
 	size_t coredump_addr;
 	size_t coredump_size;
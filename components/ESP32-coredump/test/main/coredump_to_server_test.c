@@ -63,7 +63,7 @@ _coredump_to_server_end_cb(void * priv)
 static esp_err_t
 _coredump_to_server_write_cb(void * priv, char const * const str)
 {
-    ets_printf("%s\r\n", str);
+    ets_printf("%s", str);
     return ESP_OK;
 }
 
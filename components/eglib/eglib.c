@@ -20,6 +20,9 @@ void eglib_Init(
 
 	eglib->drawing.filled_mode = false;
 	eglib->drawing.font_origin = FONT_BOTTOM;
+	eglib->drawing.glyph_buffer = NULL;
+	eglib->drawing.glyph_buffer_size = 0;
+	eglib->drawing.glyph_buffer_owned = true;
 
 
 	for(size_t i=0 ; i < sizeof(eglib->drawing.color_index) / sizeof(*eglib->drawing.color_index) ; i++) {
@@ -30,6 +33,8 @@ void eglib_Init(
 
 	eglib->hal.driver->init(eglib);
 	eglib->display.driver->init(eglib);
+	eglib_SetIndexColor(eglib, 0, 0, 0, 0);
+	eglib_SetIndexColor(eglib, 1, 0, 0, 0);
     coordinate_t width, height;
     eglib->display.driver->get_dimension(eglib, &width, &height);
     eglib->drawing.clip_xmin = 0;
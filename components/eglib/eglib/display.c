@@ -33,6 +33,34 @@ void display_default_draw_line(
 	}
 }
 
+uint8_t eglib_PackColor(eglib_t *eglib, color_t color, uint8_t *bytes) {
+	enum pixel_format_t pixel_format;
+
+	eglib_GetPixelFormat(eglib, &pixel_format);
+
+	switch(pixel_format) {
+		case PIXEL_FORMAT_8BIT_RGB:
+			bytes[0] = (color.r & 0xe0) | ((color.g & 0xe0) >> 3) | ((color.b & 0xc0) >> 6);
+			return 1;
+		case PIXEL_FORMAT_16BIT_RGB:
+			bytes[0] = (color.r & 0xf8) | (color.g >> 5);
+			bytes[1] = ((color.g >> 2) << 5) | (color.b >> 3);
+			return 2;
+		case PIXEL_FORMAT_18BIT_RGB_24BIT:
+			bytes[0] = color.r & ~0x03;
+			bytes[1] = color.g & ~0x03;
+			bytes[2] = color.b & ~0x03;
+			return 3;
+		case PIXEL_FORMAT_24BIT_RGB:
+			bytes[0] = color.r;
+			bytes[1] = color.g;
+			bytes[2] = color.b;
+			return 3;
+		default:
+			return 0;
+	}
+}
+
 coordinate_t eglib_GetWidth(eglib_t *eglib) {
 	coordinate_t width, heigh;
 
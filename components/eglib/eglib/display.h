@@ -170,18 +170,20 @@ struct display_struct {
 	/**
 	 * Pointer to a function that sends given buffer to display memory.
 	 *
+	 * For byte aligned pixel formats the buffer holds just the window:
+	 * ``width`` x ``height`` pixels packed row by row in the display format
+	 * (:c:func:`eglib_PackColor`), the first one goes to ``(x, y)``. This is
+	 * what text rendering and the frame buffer send. For the paged / sub byte
+	 * formats the buffer is the whole frame buffer and only the window is
+	 * sent from it; the st7789 and ssd drivers still expect that layout for
+	 * every format.
+	 *
 	 * :param eglib: :c:type:`eglib_t` handle.
-	 * :param buffer: Pointer to the memory buffer to be sent. The format is
-	 *   dependent on both :c:type:`pixel_format_t` from ``get_pixel_format``
-	 *   and the display dimensions from ``get_dimension``.
-	 * :param x: X :c:type:`coordinate_t` of data to be sent: X pixels lower
-	 *    than ``x`` must not be sent to the display.
-	 * :param y: Y :c:type:`coordinate_t` of data to be sent: Y pixels lower
-	 *    than ``y`` must not be sent to the display.
-	 * :param width: Width of data to be sent: X pixels greater than
-	 *   ``x + width`` must not be sent to the display.
-	 * :param height: Height of data to be sent: Y pixels greater than
-	 *   ``y + height`` must not be sent to the display.
+	 * :param buffer: Pointer to the memory buffer to be sent.
+	 * :param x: X :c:type:`coordinate_t` of the window's left column.
+	 * :param y: Y :c:type:`coordinate_t` of the window's top row.
+	 * :param width: Width of the window in pixels.
+	 * :param height: Height of the window in pixels.
 	 */
 	void (*send_buffer)(
 		eglib_t *eglib,
@@ -242,6 +244,20 @@ struct display_struct {
 			coordinate_t num_lines
 	);
 
+	/**
+	 * Optional, fills the ``width`` x ``height`` rectangle at ``(x, y)`` with
+	 * ``color``, setting the display window once for the whole area. When
+	 * `NULL`, :c:func:`eglib_DrawBox` draws it line by line.
+	 *
+	 * Coordinates are already clipped.
+	 */
+	void (*fill_rect)(
+			eglib_t *eglib,
+			coordinate_t x, coordinate_t y,
+			coordinate_t width, coordinate_t height,
+			color_t color
+	);
+
 };
 
 /**
@@ -346,6 +362,15 @@ void display_default_draw_line(
 	(eglib)->display.driver->get_pixel_format(eglib, pixel_format) \
 )
 
+/**
+ * Packs ``color`` into ``bytes`` in the display's pixel format and byte order,
+ * as used by ``send_buffer``.
+ *
+ * :return: Bytes per pixel, or ``0`` for formats with less than 8 bits per
+ *   pixel or pixels sharing bytes (:c:enum:`PIXEL_FORMAT_12BIT_RGB`).
+ */
+uint8_t eglib_PackColor(eglib_t *eglib, color_t color, uint8_t *bytes);
+
 /** Returns display width as :c:type:`coordinate_t`. */
 coordinate_t eglib_GetWidth(eglib_t *eglib);
 
@@ -196,18 +196,40 @@ static const uint8_t color_bits[PIXEL_FORMAT_COUNT] = {
 	[PIXEL_FORMAT_24BIT_RGB] = 24,
 };
 
+// bytes per pixel of the byte aligned formats, 0 for the paged / sub byte ones
+static uint8_t get_pixel_bytes(enum pixel_format_t pixel_format) {
+	if(color_bits[pixel_format] % 8)
+		return 0;
+	return color_bits[pixel_format] / 8;
+}
+
+// the rows held by the buffer: the whole display or one band
+static void get_buffer_dimension(
+	eglib_t *eglib,
+	coordinate_t *width, coordinate_t *height
+) {
+	frame_buffer_config_t *config;
+
+	config = eglib_GetDisplayConfig(eglib);
+
+	get_dimension(eglib, width, height);
+	if(config->band_height && config->band_height < *height)
+		*height = config->band_height;
+}
+
 static void region_reset(eglib_t *eglib) {
 	frame_buffer_config_t *config;
 	coordinate_t width, height;
 
 	config = eglib_GetDisplayConfig(eglib);
 
-	get_dimension(eglib, &width, &height);
+	get_buffer_dimension(eglib, &width, &height);
 
 	config->x_start = width - 1;
 	config->x_end = 0;
 	config->y_start = height - 1;
 	config->y_end = 0;
+	config->dirty_count = 0;
 }
 
 static void region_update(
@@ -225,6 +247,173 @@ static void region_update(
 		config->y_end = y;
 }
 
+static int32_t rect_area(const frame_buffer_rect_t *rect) {
+	return (int32_t)(rect->x_end - rect->x_start + 1) * (rect->y_end - rect->y_start + 1);
+}
+
+// clean pixels that the bounding box of a and b adds, the box goes to u
+static int32_t merge_cost(
+	const frame_buffer_rect_t *a,
+	const frame_buffer_rect_t *b,
+	frame_buffer_rect_t *u
+) {
+	frame_buffer_rect_t i;
+	int32_t overlap = 0;
+
+	u->x_start = a->x_start < b->x_start ? a->x_start : b->x_start;
+	u->y_start = a->y_start < b->y_start ? a->y_start : b->y_start;
+	u->x_end = a->x_end > b->x_end ? a->x_end : b->x_end;
+	u->y_end = a->y_end > b->y_end ? a->y_end : b->y_end;
+
+	i.x_start = a->x_start > b->x_start ? a->x_start : b->x_start;
+	i.y_start = a->y_start > b->y_start ? a->y_start : b->y_start;
+	i.x_end = a->x_end < b->x_end ? a->x_end : b->x_end;
+	i.y_end = a->y_end < b->y_end ? a->y_end : b->y_end;
+	if(i.x_start <= i.x_end && i.y_start <= i.y_end)
+		overlap = rect_area(&i);
+
+	return rect_area(u) - rect_area(a) - rect_area(b) + overlap;
+}
+
+// mark a rectangle as changed, clipped to the display
+static void region_add(
+	eglib_t *eglib,
+	coordinate_t x_start, coordinate_t y_start,
+	coordinate_t x_end, coordinate_t y_end
+) {
+	frame_buffer_config_t *config;
+	coordinate_t width, height;
+	frame_buffer_rect_t rect;
+
+	config = eglib_GetDisplayConfig(eglib);
+
+	get_buffer_dimension(eglib, &width, &height);
+
+	if(x_start < 0)
+		x_start = 0;
+	if(y_start < 0)
+		y_start = 0;
+	if(x_end > width - 1)
+		x_end = width - 1;
+	if(y_end > height - 1)
+		y_end = height - 1;
+	if(x_start > x_end || y_start > y_end)
+		return;
+
+	region_update(config, x_start, y_start);
+	region_update(config, x_end, y_end);
+
+	rect.x_start = x_start;
+	rect.y_start = y_start;
+	rect.x_end = x_end;
+	rect.y_end = y_end;
+
+	// Merge with the cheapest neighbour until nothing is cheap enough, the
+	// grown rectangle may now be worth merging with another one. With the
+	// list full the cheapest merge happens anyway.
+	while(config->dirty_count) {
+		frame_buffer_rect_t u, best_u;
+		int32_t cost, best_cost = 0;
+		int best = -1;
+
+		for(int i = 0 ; i < config->dirty_count ; i++) {
+			cost = merge_cost(&config->dirty[i], &rect, &u);
+			if(best < 0 || cost < best_cost) {
+				best = i;
+				best_cost = cost;
+				best_u = u;
+			}
+		}
+		if(
+			best_cost > FRAME_BUFFER_MERGE_PIXELS &&
+			config->dirty_count < FRAME_BUFFER_DIRTY_RECTS
+		)
+			break;
+		rect = best_u;
+		config->dirty[best] = config->dirty[--config->dirty_count];
+	}
+
+	config->dirty[config->dirty_count++] = rect;
+}
+
+// send a region of the buffer, in buffer coordinates, to the display
+static void send_region(
+	eglib_t *eglib,
+	coordinate_t x, coordinate_t y,
+	coordinate_t width, coordinate_t height
+) {
+	frame_buffer_config_t *config;
+	eglib_t *eglib_buffered;
+	enum pixel_format_t pixel_format;
+	coordinate_t buffer_width, buffer_height;
+	uint8_t pixel_bytes;
+	uint8_t *src;
+	uint32_t row, stride;
+	coordinate_t rows;
+
+	config = eglib_GetDisplayConfig(eglib);
+	eglib_buffered = &config->eglib_buffered;
+
+	get_pixel_format(eglib, &pixel_format);
+	get_buffer_dimension(eglib, &buffer_width, &buffer_height);
+
+	if(x < 0) {
+		width += x;
+		x = 0;
+	}
+	if(y < 0) {
+		height += y;
+		y = 0;
+	}
+	if(x + width > buffer_width)
+		width = buffer_width - x;
+	if(y + height > buffer_height)
+		height = buffer_height - y;
+	if(width <= 0 || height <= 0)
+		return;
+
+	pixel_bytes = get_pixel_bytes(pixel_format);
+	if(!pixel_bytes) {
+		eglib_buffered->display.driver->send_buffer(
+			eglib_buffered, config->buffer, x, y + config->band_y, width, height
+		);
+		return;
+	}
+
+	stride = (uint32_t)buffer_width * pixel_bytes;
+	row = (uint32_t)width * pixel_bytes;
+	src = (uint8_t *)config->buffer + stride * y + (uint32_t)x * pixel_bytes;
+
+	// full width rows are contiguous in the buffer
+	if(width == buffer_width) {
+		eglib_buffered->display.driver->send_buffer(
+			eglib_buffered, src, x, y + config->band_y, width, height
+		);
+		return;
+	}
+
+	// otherwise gather bands of rows, or send row by row
+	rows = config->band_buffer ? FRAME_BUFFER_SEND_BYTES / row : 0;
+	for(coordinate_t v = 0 ; v < height ; ) {
+		coordinate_t n = height - v;
+		uint8_t *band = src;
+
+		if(rows > 1) {
+			if(n > rows)
+				n = rows;
+			band = config->band_buffer;
+			for(coordinate_t i = 0 ; i < n ; i++)
+				memcpy(band + i * row, src + i * stride, row);
+		} else
+			n = 1;
+		eglib_buffered->display.driver->send_buffer(
+			eglib_buffered, band, x, y + config->band_y + v, width, n
+		);
+		src += stride * n;
+		v += n;
+	}
+}
+
 //
 // Display
 //
@@ -237,13 +426,18 @@ static void init(eglib_t *eglib) {
 	config = eglib_GetDisplayConfig(eglib);
 
 	get_pixel_format(eglib, &pixel_format);
-	get_dimension(eglib, &width, &height);
+	get_buffer_dimension(eglib, &width, &height);
 
 	config->buffer = calloc(1, (uint32_t)color_bits[pixel_format] * width * height / 8 );
 
 	if(config->buffer == NULL)
 		while(1);
 
+	// optional, without it narrow regions are sent row by row
+	config->band_buffer = NULL;
+	if(get_pixel_bytes(pixel_format) && !config->band_height)
+		config->band_buffer = malloc(FRAME_BUFFER_SEND_BYTES);
+
 	region_reset(eglib);
 };
 
@@ -301,7 +495,11 @@ static void draw_pixel_color(
 	config = eglib_GetDisplayConfig(eglib);
 
 	get_pixel_format(eglib, &pixel_format);
-	get_dimension(eglib, &width, &height);
+	get_buffer_dimension(eglib, &width, &height);
+	y -= config->band_y;
+
+	if(x < 0 || y < 0 || x >= width || y >= height)
+		return;
 
 	(draw_to_buffer[pixel_format])(
 		config->buffer,
@@ -310,7 +508,7 @@ static void draw_pixel_color(
 		&color
 	);
 
-	region_update(config, x, y);
+	region_add(eglib, x, y, x, y);
 };
 
 static void draw_line(
@@ -322,40 +520,147 @@ static void draw_line(
 	color_t (*get_next_color)(eglib_t *eglib)
 ) {
 	frame_buffer_config_t *config;
+	enum pixel_format_t pixel_format;
+	coordinate_t width, height;
+	coordinate_t dx = 0, dy = 0;
 
 	config = eglib_GetDisplayConfig(eglib);
 
-	region_update(config, x, y);
+	get_pixel_format(eglib, &pixel_format);
+	get_buffer_dimension(eglib, &width, &height);
+	y -= config->band_y;
 
+	// same pixels as the ili9341 line window, left and up end next to (x, y)
 	switch(direction) {
 		case DISPLAY_LINE_DIRECTION_RIGHT:
-			region_update(config, x + length - 1, y);
+			dx = 1;
+			region_add(eglib, x, y, x + length - 1, y);
 			break;
 		case DISPLAY_LINE_DIRECTION_LEFT:
-			region_update(config, x - length - 1, y);
+			dx = 1;
+			x -= length;
+			region_add(eglib, x, y, x + length - 1, y);
 			break;
 		case DISPLAY_LINE_DIRECTION_DOWN:
-			region_update(config, x, y + length - 1);
+			dy = 1;
+			region_add(eglib, x, y, x, y + length - 1);
 			break;
 		case DISPLAY_LINE_DIRECTION_UP:
-			region_update(config, x, y - length - 1);
+			dy = 1;
+			y -= length;
+			region_add(eglib, x, y, x, y + length - 1);
 			break;
 	}
-	display_default_draw_line(eglib, x, y, direction, length, get_next_color);
+
+	for( ; length-- ; x += dx, y += dy) {
+		color_t color = get_next_color(eglib);
+
+		if(x < 0 || y < 0 || x >= width || y >= height)
+			continue;
+		(draw_to_buffer[pixel_format])(
+			config->buffer,
+			width, height,
+			x, y,
+			&color
+		);
+	}
+}
+
+static void fill_rect(
+	eglib_t *eglib,
+	coordinate_t x, coordinate_t y,
+	coordinate_t fill_width, coordinate_t fill_height,
+	color_t color
+) {
+	frame_buffer_config_t *config;
+	enum pixel_format_t pixel_format;
+	coordinate_t width, height;
+	coordinate_t x_end, y_end;
+	uint8_t pixel_bytes;
+
+	config = eglib_GetDisplayConfig(eglib);
+
+	get_pixel_format(eglib, &pixel_format);
+	get_buffer_dimension(eglib, &width, &height);
+	y -= config->band_y;
+
+	x_end = x + fill_width - 1;
+	y_end = y + fill_height - 1;
+	if(x < 0)
+		x = 0;
+	if(y < 0)
+		y = 0;
+	if(x_end > width - 1)
+		x_end = width - 1;
+	if(y_end > height - 1)
+		y_end = height - 1;
+	if(x > x_end || y > y_end)
+		return;
+
+	pixel_bytes = get_pixel_bytes(pixel_format);
+	if(pixel_bytes) {
+		// pack the first pixel and replicate it: along the row, then the row down
+		uint32_t stride = (uint32_t)width * pixel_bytes;
+		uint32_t row = (uint32_t)(x_end - x + 1) * pixel_bytes;
+		uint8_t *dst = (uint8_t *)config->buffer + stride * y + (uint32_t)x * pixel_bytes;
+
+		(draw_to_buffer[pixel_format])(config->buffer, width, height, x, y, &color);
+		for(uint32_t i = pixel_bytes ; i < row ; i += pixel_bytes)
+			memcpy(dst + i, dst, pixel_bytes);
+		for(coordinate_t v = y + 1 ; v <= y_end ; v++)
+			memcpy(dst + stride * (v - y), dst, row);
+	} else {
+		for(coordinate_t v = y ; v <= y_end ; v++)
+			for(coordinate_t u = x ; u <= x_end ; u++)
+				(draw_to_buffer[pixel_format])(config->buffer, width, height, u, v, &color);
+	}
+
+	region_add(eglib, x, y, x_end, y_end);
 }
 
 static void send_buffer(
 	eglib_t *eglib,
-	void *buffer,
+	void *buffer_ptr,
 	coordinate_t x, coordinate_t y,
-	coordinate_t width, coordinate_t height
+	coordinate_t window_width, coordinate_t window_height
 ) {
-	(void)eglib;
-	(void)buffer;
-	(void)x;
-	(void)y;
-	(void)width;
-	(void)height;
+	frame_buffer_config_t *config;
+	enum pixel_format_t pixel_format;
+	coordinate_t width, height;
+	uint8_t pixel_bytes;
+	uint8_t *buffer = (uint8_t *)buffer_ptr;
+
+	config = eglib_GetDisplayConfig(eglib);
+
+	get_pixel_format(eglib, &pixel_format);
+	get_buffer_dimension(eglib, &width, &height);
+	y -= config->band_y;
+
+	// packed window, pixels in display format or color_t for the sub byte formats
+	pixel_bytes = get_pixel_bytes(pixel_format);
+	for(coordinate_t j = 0 ; j < window_height ; j++) {
+		coordinate_t v = y + j;
+		coordinate_t u0 = x < 0 ? -x : 0;
+		coordinate_t u1 = x + window_width > width ? width - x : window_width;
+
+		if(v < 0 || v >= height || u0 >= u1)
+			continue;
+		if(pixel_bytes) {
+			memcpy(
+				(uint8_t *)config->buffer + ((uint32_t)width * v + x + u0) * pixel_bytes,
+				buffer + ((uint32_t)window_width * j + u0) * pixel_bytes,
+				(uint32_t)(u1 - u0) * pixel_bytes
+			);
+		} else {
+			for(coordinate_t u = u0 ; u < u1 ; u++) {
+				color_t *color = (color_t *)(buffer + ((uint32_t)window_width * j + u) * sizeof(color_t));
+
+				(draw_to_buffer[pixel_format])(config->buffer, width, height, x + u, v, color);
+			}
+		}
+	}
+
+	region_add(eglib, x, y, x + window_width - 1, y + window_height - 1);
 };
 
 static bool refresh(eglib_t *eglib) {
@@ -375,10 +680,26 @@ eglib_t *eglib_Init_FrameBuffer(
 	frame_buffer_config_t *config,
 	const hal_t *hal_driver, void *hal_config_ptr,
 	const display_t *display_driver, void *config_ptr
+) {
+	return eglib_Init_FrameBuffer_Banded(
+		eglib, config, 0,
+		hal_driver, hal_config_ptr,
+		display_driver, config_ptr
+	);
+}
+
+eglib_t *eglib_Init_FrameBuffer_Banded(
+	eglib_t *eglib,
+	frame_buffer_config_t *config,
+	coordinate_t band_height,
+	const hal_t *hal_driver, void *hal_config_ptr,
+	const display_t *display_driver, void *config_ptr
 ) {
 	display_t *frame_buffer;
 
 	frame_buffer = &config->frame_buffer;
+	config->band_height = band_height;
+	config->band_y = 0;
 
 	eglib_Init(
 		&config->eglib_buffered,
@@ -396,6 +717,7 @@ eglib_t *eglib_Init_FrameBuffer(
 	frame_buffer->draw_line = draw_line;
 	frame_buffer->send_buffer = send_buffer;
 	frame_buffer->refresh = refresh;
+	frame_buffer->fill_rect = fill_rect;
 
 	eglib_Init(
 		eglib,
@@ -415,12 +737,7 @@ void eglib_FrameBuffer_SendPartial(
 
 	config = eglib_GetDisplayConfig(eglib);
 
-	config->eglib_buffered.display.driver->send_buffer(
-		&config->eglib_buffered,
-		config->buffer,
-		x, y,
-		width, height
-	);
+	send_region(eglib, x, y - config->band_y, width, height);
 }
 
 void eglib_FrameBuffer_SendUpdated(eglib_t *eglib) {
@@ -428,21 +745,64 @@ void eglib_FrameBuffer_SendUpdated(eglib_t *eglib) {
 
 	config = eglib_GetDisplayConfig(eglib);
 
-	eglib_FrameBuffer_SendPartial(
-		eglib,
-		config->x_start,
-		config->y_start,
-		config->x_end - config->x_start + 1,
-		config->y_end - config->y_start + 1
-	);
+	for(uint8_t i = 0 ; i < config->dirty_count ; i++) {
+		frame_buffer_rect_t *rect = &config->dirty[i];
+
+		send_region(
+			eglib,
+			rect->x_start,
+			rect->y_start,
+			rect->x_end - rect->x_start + 1,
+			rect->y_end - rect->y_start + 1
+		);
+	}
 
 	region_reset(eglib);
 }
 
+void eglib_FrameBuffer_Render(
+	eglib_t *eglib,
+	coordinate_t x, coordinate_t y,
+	coordinate_t width, coordinate_t height,
+	void (*draw)(eglib_t *eglib, void *arg), void *arg
+) {
+	frame_buffer_config_t *config;
+	coordinate_t buffer_width, buffer_height;
+	coordinate_t display_height;
+
+	config = eglib_GetDisplayConfig(eglib);
+
+	get_buffer_dimension(eglib, &buffer_width, &buffer_height);
+	display_height = eglib_GetHeight(eglib);
+
+	if(y < 0) {
+		height += y;
+		y = 0;
+	}
+	if(y + height > display_height)
+		height = display_height - y;
+
+	// each band sees the whole frame drawn, the buffer keeps its own rows
+	for(coordinate_t band = y ; band < y + height ; band += buffer_height) {
+		coordinate_t rows = y + height - band;
+
+		if(rows > buffer_height)
+			rows = buffer_height;
+		config->band_y = band;
+		region_reset(eglib);
+		draw(eglib, arg);
+		send_region(eglib, x, 0, width, rows);
+	}
+
+	config->band_y = 0;
+	region_reset(eglib);
+}
+
 void frame_buffer_Free(eglib_t *eglib) {
 	frame_buffer_config_t *config;
 
 	config = eglib_GetDisplayConfig(eglib);
 
 	free(config->buffer);
-}
\ No newline at end of file
+	free(config->band_buffer);
+}
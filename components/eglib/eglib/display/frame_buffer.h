@@ -10,6 +10,32 @@
  * =============
  */
 
+/** Maximum number of separate dirty rectangles tracked between two sends. */
+#ifndef FRAME_BUFFER_DIRTY_RECTS
+#define FRAME_BUFFER_DIRTY_RECTS 16
+#endif
+
+/**
+ * Two dirty rectangles are merged when their bounding box covers at most this
+ * many clean pixels, about what the window setup of one more send costs.
+ */
+#ifndef FRAME_BUFFER_MERGE_PIXELS
+#define FRAME_BUFFER_MERGE_PIXELS 64
+#endif
+
+/** Size of the buffer used to send dirty rectangles narrower than the display. */
+#ifndef FRAME_BUFFER_SEND_BYTES
+#define FRAME_BUFFER_SEND_BYTES 4096
+#endif
+
+/** Rectangle of the frame buffer, inclusive coordinates. */
+typedef struct {
+	coordinate_t x_start;
+	coordinate_t y_start;
+	coordinate_t x_end;
+	coordinate_t y_end;
+} frame_buffer_rect_t;
+
 /**
  * Configuration for frame buffer display.
  *
@@ -19,10 +45,18 @@ typedef struct {
 	display_t frame_buffer;
 	eglib_t eglib_buffered;
 	void *buffer;
+	// bounding box of everything drawn since the last send
 	coordinate_t x_start;
 	coordinate_t x_end;
 	coordinate_t y_start;
 	coordinate_t y_end;
+	// disjoint parts of it, sent by eglib_FrameBuffer_SendUpdated()
+	frame_buffer_rect_t dirty[FRAME_BUFFER_DIRTY_RECTS];
+	uint8_t dirty_count;
+	uint8_t *band_buffer;
+	// banded mode: the buffer holds band_height rows starting at display row band_y
+	coordinate_t band_height;
+	coordinate_t band_y;
 } frame_buffer_config_t;
 
 /**
@@ -75,7 +109,55 @@ eglib_t *eglib_Init_FrameBuffer(
 	void *display_config_ptr
 );
 
-/** Send part of the frame buffer to the display RAM. */
+/**
+ * Works like :c:func:`eglib_Init_FrameBuffer`, but the buffer only holds
+ * ``band_height`` full width rows: 240 x 40 pixels at 16 bit are 19200 bytes
+ * instead of 153600 for the whole display.
+ *
+ * A banded frame buffer is drawn with :c:func:`eglib_FrameBuffer_Render`,
+ * which runs the drawing once per band. Drawing outside of it only reaches
+ * the rows of the first band. Requires a byte aligned pixel format.
+ *
+ * :param band_height: Rows per band, 0 for the whole display.
+ */
+eglib_t *eglib_Init_FrameBuffer_Banded(
+	eglib_t *eglib,
+	frame_buffer_config_t *frame_buffer_config,
+	coordinate_t band_height,
+	const hal_t *hal_driver,
+	void *hal_config_ptr,
+	const display_t *display_driver,
+	void *display_config_ptr
+);
+
+/**
+ * Render a window of the display band by band.
+ *
+ * For every band of the buffer that overlaps rows ``y`` to ``y + height - 1``,
+ * ``draw`` is called with ``eglib`` to draw the whole frame: only what falls
+ * into the band is kept. The band is then sent to the display, within
+ * columns ``x`` to ``x + width - 1``. Nothing reaches the display while a
+ * band is being drawn, so the window changes without flicker.
+ *
+ * ``draw`` must paint every pixel of the window, usually starting with a
+ * box in the background color, as the buffer still holds the previous band.
+ * Drawing is repeated for every band; operations outside the band are
+ * cheap, text is still rasterised and clipped.
+ */
+void eglib_FrameBuffer_Render(
+	eglib_t *eglib,
+	coordinate_t x, coordinate_t y,
+	coordinate_t width, coordinate_t height,
+	void (*draw)(eglib_t *eglib, void *arg), void *arg
+);
+
+/**
+ * Send part of the frame buffer to the display RAM.
+ *
+ * For byte aligned pixel formats the display driver gets the region as a
+ * packed window (see ``send_buffer`` in :c:type:`display_struct`), for the
+ * paged / sub byte formats it gets the whole buffer and the region.
+ */
 void eglib_FrameBuffer_SendPartial(
 	eglib_t *eglib,
 	coordinate_t x, coordinate_t y,
@@ -85,7 +167,13 @@ void eglib_FrameBuffer_SendPartial(
 /** Send the whole frame buffer to the display RAM. */
 #define eglib_FrameBuffer_Send(eglib) eglib_FrameBuffer_SendPartial(eglib, 0, 0, eglib_GetWidth(eglib), eglib_GetHeight(eglib))
 
-/** Send only updated parts of the frame buffer to the display RAM. */
+/**
+ * Send only updated parts of the frame buffer to the display RAM.
+ *
+ * Drawing operations record the rectangles they touch, overlapping or nearby
+ * ones are merged as they are added. Each remaining rectangle is sent on its
+ * own, so two small changes far apart do not send everything between them.
+ */
 void eglib_FrameBuffer_SendUpdated(eglib_t *eglib);
 
 /** Free memory previously allocated by :c:func:`eglib_Init_FrameBuffer`. */
@@ -313,6 +313,31 @@ static uint8_t get_bytes_per_pixel(eglib_t *eglib) {
 	}
 }
 
+// color in the panel's pixel format, returns the number of bytes
+static int pack_color(eglib_t *eglib, color_t color, uint8_t *buf) {
+	ili9341_config_t *display_config = eglib_GetDisplayConfig(eglib);
+	switch(display_config->color) {
+	case ILI9341_COLOR_12_BIT:
+		buf[0] = color.r & 0xf0;
+		buf[0] |= (color.g & 0xf0) >> 4;
+		buf[1] = color.b & 0xf0;
+		return 2;
+	case ILI9341_COLOR_16_BIT:
+		buf[0] = color.r & 0xf8;
+		buf[0] |= color.g >> 5;
+		buf[1] = (color.g >> 2) << 5;
+		buf[1] |= color.b >> 3;
+		return 2;
+	case ILI9341_COLOR_18_BIT:
+		buf[0] = color.r & ~0x03;
+		buf[1] = color.g & ~0x03;
+		buf[2] = color.b & ~0x03;
+		return 3;
+	default:
+		while(true);
+	}
+}
+
 static void clear_memory(eglib_t *eglib) {
 	return; // +++++++++++++++++++++++++++++++++++++++++ return to help debugging
 	ili9341_config_t *display_config;
@@ -333,37 +358,8 @@ static void clear_memory(eglib_t *eglib) {
 }
 
 static void send_pixel(eglib_t *eglib, color_t color) {
-	ili9341_config_t *display_config;
-	uint8_t buff[3];
-
-	display_config = eglib_GetDisplayConfig(eglib);
-
-	switch(display_config->color) {
-		case ILI9341_COLOR_12_BIT:
-			buff[0] = color.r & 0xf0;
-			buff[0] |= (color.g & 0xf0) >> 4;
-			buff[1] = color.b & 0xf0;
-			for(uint8_t i=0 ; i < 2 ; i++)
-				eglib_SendDataByte(eglib, buff[i]);
-			break;
-		case ILI9341_COLOR_16_BIT:
-			buff[0] = color.r & 0xf8;
-			buff[0] |= color.g >> 5;
-			buff[1] = (color.g >> 2) << 5;
-			buff[1] |= color.b >> 3;
-			for(uint8_t i=0 ; i < 2 ; i++)
-				eglib_SendDataByte(eglib, buff[i]);
-			break;
-		case ILI9341_COLOR_18_BIT:
-			buff[0] = color.r & ~0x03;
-			buff[1] = color.g & ~0x03;
-			buff[2] = color.b & ~0x03;
-			for(uint8_t i=0 ; i < 3 ; i++)
-				eglib_SendDataByte(eglib, buff[i]);
-			break;
-		default:
-			while(true);
-	}
+	uint8_t buff[4];
+	eglib_SendData(eglib, buff, pack_color(eglib, color, buff));
 }
 
 //
@@ -729,34 +725,26 @@ static void draw_line(
 		ESP_LOGW("draw_line","draw_line method not implemented");
 	}
 	eglib_SendCommandByte(eglib, ILI9341_MEMORY_WRITE);
-	color_t color = eglib->drawing.color_index[0];
-	int len_pix=get_bytes_per_pixel(eglib);  // max 3
-	uint8_t buf[4] = { 0,0,0,0 };
-	ili9341_config_t *display_config = eglib_GetDisplayConfig(eglib);
-	switch(display_config->color) {
-	case ILI9341_COLOR_12_BIT:
-		buf[0] = color.r & 0xf0;
-		buf[0] |= (color.g & 0xf0) >> 4;
-		buf[1] = color.b & 0xf0;
-		break;
-	case ILI9341_COLOR_16_BIT:
-		buf[0] = color.r & 0xf8;
-		buf[0] |= color.g >> 5;
-		buf[1] = (color.g >> 2) << 5;
-		buf[1] |= color.b >> 3;
-		break;
-	case ILI9341_COLOR_18_BIT:
-		buf[0] = color.r & ~0x03;
-		buf[1] = color.g & ~0x03;
-		buf[2] = color.b & ~0x03;
-		break;
-	default:
-		while(true);
-	}
-	for( int i=0; i<length; i++ ){
-		for(int i=0;i < len_pix; i++)
-			eglib_SendDataByte(eglib, buf[i]);
-	}
+	uint8_t buf[4];
+	int len_pix = pack_color(eglib, eglib->drawing.color_index[0], buf);  // max 3
+	eglib_SendDataRepeat(eglib, buf, len_pix, length);
+	eglib_CommEnd(eglib);
+}
+
+static void fill_rect(
+	eglib_t *eglib,
+	coordinate_t x, coordinate_t y,
+	coordinate_t width, coordinate_t height,
+	color_t color
+) {
+	uint8_t buf[4];
+	int len_pix = pack_color(eglib, color, buf);
+	eglib_CommBegin(eglib);
+	y+=34;
+	set_column_address(eglib, x, x + width - 1);
+	set_row_address(eglib, y, y + height - 1);
+	eglib_SendCommandByte(eglib, ILI9341_MEMORY_WRITE);
+	eglib_SendDataRepeat(eglib, buf, len_pix, (uint32_t)width * height);
 	eglib_CommEnd(eglib);
 }
 
@@ -774,7 +762,7 @@ static void send_buffer(
 	eglib_CommBegin(eglib);
 	y+=34;
     set_column_address(eglib, x, x + width -1);
-    set_row_address(eglib, y-height -1, y );
+    set_row_address(eglib, y, y + height - 1);
     eglib_SendCommandByte(eglib, ILI9341_MEMORY_WRITE);
     eglib_SendData( eglib, buffer, width*height*get_bytes_per_pixel(eglib) );
 	eglib_CommEnd(eglib);
@@ -853,7 +841,8 @@ const display_t ili9341 = {
 	.send_buffer = send_buffer,
 	.refresh = refresh,
 	.set_scroll_margins = set_scroll_margins,
-	.scroll = scroll
+	.scroll = scroll,
+	.fill_rect = fill_rect,
 };
 
 //
@@ -72,32 +72,21 @@ static void send_buffer(
        coordinate_t x, coordinate_t y,
        coordinate_t width, coordinate_t height
 ) {
-	tga_config_t *config;
-	uint8_t *buffer = (uint8_t *)buffer_ptr;
+	uint8_t *pixel = (uint8_t *)buffer_ptr;
 	color_t color;
-	coordinate_t y_start, y_end, x_start, x_end;
-
-	config = eglib_GetDisplayConfig(eglib);
-
-	y_start = x;
-	y_end = y + height;
-	x_start = x;
-	x_end = x + width;
-
-	for(y = y_start; y < y_end ; y++) {
-		for(x = x_start; x < x_end ; x++) {
-			uint8_t *pixel;
-
-			pixel = buffer + (config->width * y + x) * 3;;
 
+	// packed window, 3 bytes per pixel
+	for(coordinate_t v = 0; v < height ; v++) {
+		for(coordinate_t u = 0; u < width ; u++) {
 			color.r = *pixel;
 			pixel++;
 			color.g = *pixel;
 			pixel++;
 			color.b = *pixel;
-			eglib_DrawPixelColor(
+			pixel++;
+			draw_pixel_color(
 				eglib,
-				x, y,
+				x + u, y + v,
 				color
 			);
 		}
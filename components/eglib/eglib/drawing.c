@@ -65,6 +65,15 @@ void eglib_SetIndexColor(
   eglib->drawing.color_index[idx].r = r;
   eglib->drawing.color_index[idx].g = g;
   eglib->drawing.color_index[idx].b = b;
+  if(idx < 2) {
+    // glyphs are rendered straight in the display's format, pack once here
+    uint8_t bytes = eglib_PackColor(eglib, eglib->drawing.color_index[idx], eglib->drawing.packed_color[idx]);
+    if(bytes == 0) {
+      memcpy(eglib->drawing.packed_color[idx], &eglib->drawing.color_index[idx], sizeof(color_t));
+      bytes = sizeof(color_t);
+    }
+    eglib->drawing.pixel_bytes = bytes;
+  }
   // ESP_LOGI("eglib_SetIndexColor","R:%d G:%d B:%d", eglib->drawing.color_index[0].r, eglib->drawing.color_index[0].g, eglib->drawing.color_index[0].b );
 }
 
@@ -218,7 +227,7 @@ static void draw_fast_90_line(
   		if(y1 >= eglib->drawing.clip_ymax)
   			y1 = eglib->drawing.clip_ymax;
   		if(y2 <= eglib->drawing.clip_ymin )
-  			y1 = eglib->drawing.clip_ymin;
+  			y2 = eglib->drawing.clip_ymin;
   		length = y1-y2;
   		break;
   	}
@@ -728,6 +737,16 @@ void eglib_DrawBox(
   coordinate_t x, coordinate_t y,
   coordinate_t width, coordinate_t height
 ) {
+  if(eglib->display.driver->fill_rect != NULL && width > 0 && height > 0) {
+    // same area as the lines below: columns x..x+width-1, rows y..y+height-1, clipped
+    coordinate_t x1 = x > eglib->drawing.clip_xmin ? x : eglib->drawing.clip_xmin;
+    coordinate_t x2 = x + width < eglib->drawing.clip_xmax ? x + width : eglib->drawing.clip_xmax;
+    coordinate_t y1 = y > eglib->drawing.clip_ymin ? y : eglib->drawing.clip_ymin;
+    coordinate_t y2 = y + height - 1 < eglib->drawing.clip_ymax ? y + height - 1 : eglib->drawing.clip_ymax;
+    if(x2 - x1 >= 1 && y2 >= y1)
+      eglib->display.driver->fill_rect(eglib, x1, y1, x2 - x1, y2 - y1 + 1, eglib->drawing.color_index[0]);
+    return;
+  }
     if (width !=0)
   for( ; height ; height--, y++)
     eglib_DrawHLine(eglib, x, y, width);
@@ -1154,28 +1173,87 @@ bool eglib_AddUnicodeBlockToFont(
   if(font->unicode_blocks_count == FONT_MAX_UNICODE_BLOCKS)
     return true;
 
-  font->unicode_blocks[font->unicode_blocks_count] = unicode_block;
+  // keep the blocks sorted for the binary search in eglib_GetGlyph()
+  int i = font->unicode_blocks_count;
+  for( ; i > 0 && font->unicode_blocks[i-1]->charcode_start > unicode_block->charcode_start ; i--)
+    font->unicode_blocks[i] = font->unicode_blocks[i-1];
+  font->unicode_blocks[i] = unicode_block;
   font->unicode_blocks_count++;
+  if(font->ascii == NULL && unicode_block->charcode_start <= 0x20 && unicode_block->charcode_end >= 0x7e)
+    font->ascii = unicode_block;
 
   return false;
 }
 
-const struct glyph_t *eglib_GetGlyph(eglib_t *eglib, wchar_t unicode_char) {
-  const struct font_t *font;
-
-  font = eglib->drawing.font;
+static size_t glyph_buffer_size(eglib_t *eglib, const struct font_t *font) {
+  int ascheight = font->ascent - font->descent;
+  int height = font->pixel_size > ascheight ? font->pixel_size : ascheight;
+  int advance = 0;
 
   for(int i = 0 ; i < font->unicode_blocks_count ; i++) {
-    if(
-      unicode_char >= (wchar_t)font->unicode_blocks[i]->charcode_start
-      && unicode_char <= (wchar_t)font->unicode_blocks[i]->charcode_end
-    ) {
-      return font->unicode_blocks[i]->glyphs[unicode_char - font->unicode_blocks[i]->charcode_start];
+    const struct glyph_unicode_block_t *block = font->unicode_blocks[i];
+    for(wchar_t c = block->charcode_start ; c <= (wchar_t)block->charcode_end ; c++) {
+      const struct glyph_t *glyph = block->glyphs[c - block->charcode_start];
+      if(glyph != NULL && glyph->advance > advance)
+        advance = glyph->advance;
     }
   }
+  return (size_t)advance * height * eglib->drawing.pixel_bytes;
+}
+
+static bool glyph_buffer_grow(eglib_t *eglib, size_t size) {
+  if(size <= eglib->drawing.glyph_buffer_size)
+    return false;
+  if(!eglib->drawing.glyph_buffer_owned)
+    return true;
+
+  uint8_t *buffer = realloc(eglib->drawing.glyph_buffer, size);
+  if(buffer == NULL) {
+    ESP_LOGE("eglib", "no memory for %u byte glyph buffer", (unsigned)size);
+    return true;
+  }
+  eglib->drawing.glyph_buffer = buffer;
+  eglib->drawing.glyph_buffer_size = size;
+  return false;
+}
+
+bool eglib_ReserveGlyphBuffer(eglib_t *eglib, const struct font_t *font) {
+  return glyph_buffer_grow(eglib, glyph_buffer_size(eglib, font));
+}
+
+void eglib_SetGlyphBuffer(eglib_t *eglib, uint8_t *buffer, size_t size) {
+  if(eglib->drawing.glyph_buffer_owned)
+    free(eglib->drawing.glyph_buffer);
+  eglib->drawing.glyph_buffer = buffer;
+  eglib->drawing.glyph_buffer_size = buffer ? size : 0;
+  eglib->drawing.glyph_buffer_owned = (buffer == NULL);
+}
+
+static const struct glyph_t *search_glyph(const struct font_t *font, wchar_t unicode_char) {
+  int lo = 0, hi = font->unicode_blocks_count - 1;
+  while(lo <= hi) {
+    int mid = (lo + hi) / 2;
+    const struct glyph_unicode_block_t *block = font->unicode_blocks[mid];
+    if(unicode_char < (wchar_t)block->charcode_start)
+      hi = mid - 1;
+    else if(unicode_char > (wchar_t)block->charcode_end)
+      lo = mid + 1;
+    else
+      return block->glyphs[unicode_char - block->charcode_start];
+  }
   return NULL;
 }
 
+static inline const struct glyph_t *get_glyph(const struct font_t *font, wchar_t unicode_char) {
+  if(unicode_char >= 0x20 && unicode_char <= 0x7e && font->ascii != NULL)
+    return font->ascii->glyphs[unicode_char - font->ascii->charcode_start];
+  return search_glyph(font, unicode_char);
+}
+
+const struct glyph_t *eglib_GetGlyph(eglib_t *eglib, wchar_t unicode_char) {
+  return get_glyph(eglib->drawing.font, unicode_char);
+}
+
 /*
 struct glyph_t {
         uint8_t width : 7;   // Bitmap width
@@ -1196,14 +1274,10 @@ struct font_t {
 };
 */
 
-#define MAX 400
-
-void eglib_DrawGlyph(eglib_t *eglib, coordinate_t x, coordinate_t y, const struct glyph_t *glyph) {
-	if(glyph == NULL)
-		return;
-
-	// ESP_LOGI("eglib_DrawGlyph", "eglib_DrawGlyph color: R:%d G:%d B:%d", eglib->drawing.color_index[0].r, eglib->drawing.color_index[0].g, eglib->drawing.color_index[0].b );
-	uint8_t *buffer;
+// Renders glyphs of one line side by side into the scratch buffer and sends
+// them as a single window. The cells tile exactly (each glyph is its advance
+// wide), so the result is the same as drawing the glyphs one by one.
+static void draw_glyph_run(eglib_t *eglib, coordinate_t x, coordinate_t y, const struct glyph_t **glyphs, int count) {
 	int ascent = eglib->drawing.font->ascent;
 	int descent = eglib->drawing.font->descent;
 	int ascheight = ascent - descent;
@@ -1217,63 +1291,93 @@ void eglib_DrawGlyph(eglib_t *eglib, coordinate_t x, coordinate_t y, const struc
 	else if( eglib->drawing.font_origin == FONT_TOP )
 		alignment -= alignment;
 
-	int width = glyph->advance;
+	int width = 0;
+	for(int i=0; i < count; i++)
+		width += glyphs[i]->advance;
 	int height = eglib->drawing.font->pixel_size > ascheight ? eglib->drawing.font->pixel_size : ascheight;
 
-	int top = glyph->top;
-	int head = ascent - top;
-	uint32_t pos3 = 0;
-
-	int startx = MAX;
-	int starty = MAX;
-	int lenx = 0;
-	int leny = 0;
-
-	buffer = malloc( height*width*3 );
 	int y1 = 0;
 	if( eglib->drawing.filled_mode == false ){
 		y1 =  height/8;   // WA as fonts bounding boxes to high over the top
 	}
 
-	for(coordinate_t v1=y1; v1 < height ; v1++){
-		//char line[width+1];
-		for(coordinate_t u=0 ; u < width; u++) {
-			coordinate_t v = v1 - head;  // read glyph from right row
-			if( eglib_inClipArea( eglib, u+x+1, v1-height+y ) ){
-				if( startx > u )  // the following code captures the minimum bounding box from what is rendered
-					startx = u;
-				if( starty > v1 )
-					starty = v1;
-				if( lenx < u-startx )
-					lenx = u-startx;
-				if( leny < v1-starty )
-					leny = v1-starty;
-				*(color_t *)(buffer+pos3) = eglib->drawing.color_index[1];  // preinitialize with background
-				// line[u] = '.';
-				if( (u < glyph->width) && (v < glyph->height) && v>=0 && u>=0  )
-				{
-					if( get_bit2( glyph, u, v ) ){
-						*(color_t *)(buffer+pos3) = eglib->drawing.color_index[0];
-						// line[u] = 'X';
-					}
+	// intersect the glyph cells with the clip area once, pixel (u,v1) lands on (u+x+1, v1-height+y)
+	int startx = eglib->drawing.clip_xmin - x - 1;
+	int endx = eglib->drawing.clip_xmax - x - 1;
+	int starty = eglib->drawing.clip_ymin - y + height;
+	int endy = eglib->drawing.clip_ymax - y + height;
+	if( startx < 0 )
+		startx = 0;
+	if( endx > width-1 )
+		endx = width-1;
+	if( starty < y1 )
+		starty = y1;
+	if( endy > height-1 )
+		endy = height-1;
+	// the window is sent with pixel (u,v1) on (x+u, top+v1), keep it on the display
+	int top = y+alignment-height-1;
+	if( startx < -x )
+		startx = -x;
+	if( endx > eglib_GetWidth(eglib)-1-x )
+		endx = eglib_GetWidth(eglib)-1-x;
+	if( starty < -top )
+		starty = -top;
+	if( endy > eglib_GetHeight(eglib)-1-top )
+		endy = eglib_GetHeight(eglib)-1-top;
+	if( startx > endx || starty > endy ) // glyphs are off clip area
+		return;
+	int lenx = endx - startx + 1;
+	int leny = endy - starty + 1;
+
+	int pixel_bytes = eglib->drawing.pixel_bytes;
+	size_t size = (size_t)lenx*leny*pixel_bytes;
+	if( size > eglib->drawing.glyph_buffer_size ){
+		if( count > 1 && (size > EGLIB_TEXT_RUN_BUFFER_MAX || glyph_buffer_grow( eglib, size )) ){
+			// too long for one window, split the run
+			int half = count/2;
+			coordinate_t xh = x;
+			for(int i=0; i < half; i++)
+				xh += glyphs[i]->advance;
+			draw_glyph_run( eglib, x, y, glyphs, half );
+			draw_glyph_run( eglib, xh, y, glyphs+half, count-half );
+			return;
+		}
+		if( count == 1 && eglib_ReserveGlyphBuffer( eglib, eglib->drawing.font ) )
+			return;
+	}
+
+	// pixels are stored pre-packed in the display's format
+	const uint8_t *fg = eglib->drawing.packed_color[0];
+	const uint8_t *bg = eglib->drawing.packed_color[1];
+	uint8_t *pix = eglib->drawing.glyph_buffer;
+	for(int v1=starty; v1 <= endy ; v1++){
+		int cell = 0;  // run column where the current glyph starts
+		for(int i=0; i < count && cell <= endx; cell += glyphs[i++]->advance){
+			const struct glyph_t *glyph = glyphs[i];
+			int u0 = startx > cell ? startx-cell : 0;
+			int u1 = endx < cell+glyph->advance-1 ? endx-cell : glyph->advance-1;
+			int v = v1 - (ascent - glyph->top);  // read glyph from right row
+			bool row = v >= 0 && v < glyph->height;
+			for(int u=u0 ; u <= u1; u++){
+				const uint8_t *c = (row && u < glyph->width && get_bit2( glyph, u, v )) ? fg : bg;
+				if( pixel_bytes == 2 ){
+					pix[0] = c[0];
+					pix[1] = c[1];
 				}
-				pos3 +=3;
+				else
+					memcpy( pix, c, pixel_bytes );
+				pix += pixel_bytes;
 			}
 		}
-		// line[width] = 0;
-		// ESP_LOGI("Bitmap","L-%02d: %s", v1, line);   // debug bitmap
 	}
-	lenx += 1;
-	leny += 1;
+	// ESP_LOGI("eglib_DrawGlyph 3","x:%d, y:%d, sx:%d sy:%d, wid:%d hei:%d", x,y, x+startx, y+alignment+starty-height-1, lenx, leny );
+	eglib->display.driver->send_buffer( eglib, eglib->drawing.glyph_buffer, x+startx, top+starty, lenx, leny );
+}
 
-	if( startx >= MAX || starty >= MAX ){ // glyph is off clip area
-		free( buffer );
+void eglib_DrawGlyph(eglib_t *eglib, coordinate_t x, coordinate_t y, const struct glyph_t *glyph) {
+	if(glyph == NULL)
 		return;
-	}
-	// ESP_LOGI("eglib_DrawGlyph 2","Window starts x:%d y:%d len x:%d y:%d", startx, starty, lenx, leny );
-	// ESP_LOGI("eglib_DrawGlyph 3","x:%d, y:%d, sx:%d sy:%d, wid:%d hei:%d", x,y, x+startx, y+alignment+starty -(height-leny), lenx, leny );
-	eglib->display.driver->send_buffer( eglib, buffer, x+startx, y+alignment+starty -(height-leny), lenx, leny );
-	free( buffer );
+	draw_glyph_run( eglib, x, y, &glyph, 1 );
 }
 
 
@@ -1281,9 +1385,15 @@ void eglib_DrawGlyph(eglib_t *eglib, coordinate_t x, coordinate_t y, const struc
 
 size_t draw_missing_glyph(eglib_t *eglib, wchar_t w, coordinate_t x, coordinate_t y);
 
-size_t draw_missing_glyph(eglib_t *eglib, wchar_t w, coordinate_t x, coordinate_t y) {
+static size_t missing_glyph_advance(eglib_t *eglib, wchar_t w) {
   if( w == 0x0a || w == 0x0d ) // no reason to draw CR/LF
 	  return 0;
+  return MISSING_GLYPH_ADVANCE;
+}
+
+size_t draw_missing_glyph(eglib_t *eglib, wchar_t w, coordinate_t x, coordinate_t y) {
+  if( missing_glyph_advance(eglib, w) == 0 )
+	  return 0;
   const struct font_t *font;
   coordinate_t box_x, box_y, box_width, box_height;
 
@@ -1335,43 +1445,63 @@ static wchar_t utf8_nextchar(const char *utf8_text, uint16_t *index) {
     return c;
 }
 
+// Glyphs of the text the font has, decoded once for drawing and measuring
+typedef struct {
+  const struct glyph_t *glyphs[EGLIB_TEXT_RUN_GLYPHS];
+  int count;
+  coordinate_t width;  // sum of the advances
+  wchar_t missing;     // character that ended the run and is not in the font, 0 if none
+} text_run_t;
+
+static void next_text_run(eglib_t *eglib, const char *utf8_text, uint16_t *index, text_run_t *run) {
+  const struct font_t *font = eglib->drawing.font;
+  uint16_t i = *index;
+  int count = 0;
+  coordinate_t width = 0;
+  run->missing = 0;
+  while(utf8_text[i] && count < EGLIB_TEXT_RUN_GLYPHS) {
+    wchar_t w = (uint8_t)utf8_text[i] < 0x80 ? utf8_text[i++] : utf8_nextchar(utf8_text, &i);
+    const struct glyph_t *glyph = get_glyph(font, w);
+    if(glyph == NULL) {
+      run->missing = w;
+      break;
+    }
+    run->glyphs[count++] = glyph;
+    width += glyph->advance;
+  }
+  *index = i;
+  run->count = count;
+  run->width = width;
+}
+
 size_t eglib_DrawText(eglib_t *eglib, coordinate_t x, coordinate_t y, const char *utf8_text) {
-  const struct glyph_t *glyph;
+  text_run_t run;
   // ESP_LOGI( "DrawText()",">%s<  X:%d Y:%d",utf8_text, x,y );
   size_t total_advance = 0;
   for(uint16_t index=0 ; utf8_text[index] ; ) {
-	wchar_t w = utf8_nextchar(utf8_text, &index);
-    glyph = eglib_GetGlyph(eglib, w );
-    if(glyph == NULL) {
-      x += draw_missing_glyph(eglib, w, x, y);
-      total_advance += x;
-    } else {
-      eglib_DrawGlyph(eglib, x, y, glyph);
-      x += glyph->advance;
-      total_advance += glyph->advance;
+    next_text_run(eglib, utf8_text, &index, &run);
+    if(run.count)
+      draw_glyph_run(eglib, x, y, run.glyphs, run.count);
+    x += run.width;
+    total_advance += run.width;
+    if(run.missing) {
+      size_t advance = draw_missing_glyph(eglib, run.missing, x, y);
+      x += advance;
+      total_advance += advance;
     }
   }
   return total_advance;
 }
 
 coordinate_t eglib_GetTextWidth(eglib_t *eglib, const char *utf8_text) {
-  // ESP_LOGI( "getWidth",">%s<",utf8_text );
-  coordinate_t width;
-  width = 0;
-  for(uint16_t index=0 ; utf8_text[index]; index++ ) {
-    const struct glyph_t *glyph;
-    glyph = eglib_GetGlyph(eglib, utf8_text[index] );
-    // glyph = eglib_GetGlyph(eglib, utf8_nextchar(utf8_text, &index));
-    if(glyph == NULL){
-      width += eglib->drawing.font->pixel_size;
-      // ESP_LOGI( "getWidth","NULL Glyph W: %c, w:%d", utf8_text[index], eglib->drawing.font->pixel_size  );
-    }
-    else{
-    	// ESP_LOGI( "getWidth","Glyph W: %c, w:%d", utf8_text[index], glyph->advance  );
-      width += glyph->advance;
-    }
+  text_run_t run;
+  coordinate_t width = 0;
+  for(uint16_t index=0 ; utf8_text[index] ; ) {
+    next_text_run(eglib, utf8_text, &index, &run);
+    width += run.width;
+    if(run.missing)
+      width += missing_glyph_advance(eglib, run.missing);
   }
-  // ESP_LOGI( "getWidth","RET: w:%d", width );
   return width;
 }
 
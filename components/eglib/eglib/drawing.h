@@ -14,6 +14,13 @@
 #define EGLIB_DRAW_ALL (EGLIB_DRAW_UPPER_RIGHT|EGLIB_DRAW_UPPER_LEFT|EGLIB_DRAW_LOWER_RIGHT|EGLIB_DRAW_LOWER_LEFT)
 
 
+/* eglib_DrawText renders up to this many glyphs into one buffer and sends them as one window */
+#define EGLIB_TEXT_RUN_GLYPHS 32
+/* Longer runs are split instead of growing the glyph buffer beyond this */
+#ifndef EGLIB_TEXT_RUN_BUFFER_MAX
+#define EGLIB_TEXT_RUN_BUFFER_MAX 16384
+#endif
+
 typedef enum _font_origin {  FONT_BOTTOM, FONT_MIDDLE, FONT_TOP } e_font_origin;
 
 typedef struct s_drawing{
@@ -23,6 +30,11 @@ typedef struct s_drawing{
 		bool filled_mode;
 		e_font_origin font_origin;
         coordinate_t clip_xmin, clip_xmax, clip_ymin, clip_ymax;
+		uint8_t packed_color[2][3]; // color_index[0..1] in the display's pixel format, see eglib_PackColor()
+		uint8_t pixel_bytes;        // bytes per packed pixel
+		uint8_t *glyph_buffer;      // scratch for glyphs and text runs, see eglib_SetGlyphBuffer()
+		size_t glyph_buffer_size;
+		bool glyph_buffer_owned;    // allocated by eglib and grown on demand
 } drawing_t;
 
 
@@ -890,10 +902,15 @@ struct font_t {
 	int16_t descent;
 	/** The distance that must be placed between two lines of text. */
 	uint16_t line_space;
-	/** Array of glyph unicode blocks. */
+	/** Array of glyph unicode blocks, sorted by ``charcode_start``, not overlapping. */
 	const struct glyph_unicode_block_t *unicode_blocks[FONT_MAX_UNICODE_BLOCKS];
 	/** Number of ``unicode_blocks``. */
 	uint8_t unicode_blocks_count;
+	/**
+	 * Block with all printable ASCII characters (``0x20`` to ``0x7e``), indexed
+	 * directly by :c:func:`eglib_GetGlyph`, or `NULL`. Set by the font generator.
+	 */
+	const struct glyph_unicode_block_t *ascii;
 };
 
 /**
@@ -907,7 +924,8 @@ void eglib_SetFont(eglib_t *eglib, const struct font_t *font);
 /**
  * Add given unicode block to font.
  *
- * Returns `true` in case of error, `false` on success.
+ * The block is inserted in charcode order and must not overlap the font's
+ * other blocks. Returns `true` in case of error, `false` on success.
  *
  * Example:
  *
@@ -927,9 +945,32 @@ bool eglib_AddUnicodeBlockToFont(
 	const struct glyph_unicode_block_t *unicode_block
 );
 
+/**
+ * Reserve the glyph scratch buffer for the largest glyph of given font.
+ *
+ * Glyphs are rendered into this buffer before they are sent to the display.
+ * It grows on demand when a glyph of a larger font is drawn, calling this
+ * for the largest font at start up avoids the allocation while drawing.
+ *
+ * Returns `true` if the buffer can not hold the font's glyphs.
+ */
+bool eglib_ReserveGlyphBuffer(eglib_t *eglib, const struct font_t *font);
+
+/**
+ * Use given memory as glyph scratch buffer instead of the heap.
+ *
+ * Glyphs that do not fit into ``size`` bytes (2 or 3 bytes per pixel, depending
+ * on the display's pixel format) are not drawn.
+ * Passing `NULL` returns to a heap buffer allocated on demand.
+ */
+void eglib_SetGlyphBuffer(eglib_t *eglib, uint8_t *buffer, size_t size);
+
 /**
  * Return given unicode character's :c:type:`glyph_t` or `NULL` if unsupported
  * by font.
+ *
+ * Printable ASCII is a direct index into the font's ``ascii`` block, other
+ * characters are looked up with a binary search over the unicode blocks.
  */
 const struct glyph_t *eglib_GetGlyph(eglib_t *eglib, wchar_t unicode_char);
 
@@ -966,6 +1007,9 @@ size_t eglib_DrawWChar(eglib_t *eglib, coordinate_t x, coordinate_t y, wchar_t u
 /**
  * Draw given UTF-8 text starting at ``(x, y)``.
  *
+ * Consecutive glyphs are rendered into one buffer and sent to the display as
+ * a single window, see :c:macro:`EGLIB_TEXT_RUN_GLYPHS`.
+ *
  * Example:
  *
  * .. literalinclude:: eglib_DrawText.c
@@ -995,7 +1039,8 @@ size_t eglib_DrawText(eglib_t *eglib, coordinate_t x, coordinate_t y, const char
 #define eglib_DrawTextCentered(eglib, x, y, utf8_text) eglib_DrawText(eglib, x - eglib_GetTextWidth(eglib, utf8_text) / 2, y, utf8_text)
 
 /**
- * Return the width in pixels of the given UTF-8 text.
+ * Return the width in pixels of the given UTF-8 text, the advance
+ * :c:func:`eglib_DrawText` returns for it.
  *
  * :See also: :c:func:`eglib_SetFont`.
  */
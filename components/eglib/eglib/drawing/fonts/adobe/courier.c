@@ -2566,6 +2566,7 @@ const struct font_t font_Adobe_Courier_8px = {
     &unicode_block_Adobe_Courier_8px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_Courier_8px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_Courier_10px_BasicLatin = {
@@ -5134,6 +5135,7 @@ const struct font_t font_Adobe_Courier_10px = {
     &unicode_block_Adobe_Courier_10px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_Courier_10px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_Courier_11px_BasicLatin = {
@@ -7702,6 +7704,7 @@ const struct font_t font_Adobe_Courier_11px = {
     &unicode_block_Adobe_Courier_11px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_Courier_11px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_Courier_12px_BasicLatin = {
@@ -10270,6 +10273,7 @@ const struct font_t font_Adobe_Courier_12px = {
     &unicode_block_Adobe_Courier_12px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_Courier_12px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_Courier_14px_BasicLatin = {
@@ -12838,6 +12842,7 @@ const struct font_t font_Adobe_Courier_14px = {
     &unicode_block_Adobe_Courier_14px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_Courier_14px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_Courier_17px_BasicLatin = {
@@ -15406,6 +15411,7 @@ const struct font_t font_Adobe_Courier_17px = {
     &unicode_block_Adobe_Courier_17px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_Courier_17px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_Courier_18px_BasicLatin = {
@@ -17974,6 +17980,7 @@ const struct font_t font_Adobe_Courier_18px = {
     &unicode_block_Adobe_Courier_18px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_Courier_18px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_Courier_20px_BasicLatin = {
@@ -20542,6 +20549,7 @@ const struct font_t font_Adobe_Courier_20px = {
     &unicode_block_Adobe_Courier_20px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_Courier_20px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_Courier_24px_BasicLatin = {
@@ -23110,6 +23118,7 @@ const struct font_t font_Adobe_Courier_24px = {
     &unicode_block_Adobe_Courier_24px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_Courier_24px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_Courier_25px_BasicLatin = {
@@ -25678,6 +25687,7 @@ const struct font_t font_Adobe_Courier_25px = {
     &unicode_block_Adobe_Courier_25px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_Courier_25px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_Courier_34px_BasicLatin = {
@@ -28246,4 +28256,5 @@ const struct font_t font_Adobe_Courier_34px = {
     &unicode_block_Adobe_Courier_34px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_Courier_34px_BasicLatin,
 };
@@ -2566,6 +2566,7 @@ const struct font_t font_Adobe_NewCenturySchoolbookRoman_8px = {
     &unicode_block_Adobe_NewCenturySchoolbookRoman_8px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_NewCenturySchoolbookRoman_8px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_NewCenturySchoolbookRoman_10px_BasicLatin = {
@@ -5134,6 +5135,7 @@ const struct font_t font_Adobe_NewCenturySchoolbookRoman_10px = {
     &unicode_block_Adobe_NewCenturySchoolbookRoman_10px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_NewCenturySchoolbookRoman_10px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_NewCenturySchoolbookRoman_11px_BasicLatin = {
@@ -7702,6 +7704,7 @@ const struct font_t font_Adobe_NewCenturySchoolbookRoman_11px = {
     &unicode_block_Adobe_NewCenturySchoolbookRoman_11px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_NewCenturySchoolbookRoman_11px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_NewCenturySchoolbookRoman_14px_BasicLatin = {
@@ -10270,6 +10273,7 @@ const struct font_t font_Adobe_NewCenturySchoolbookRoman_14px = {
     &unicode_block_Adobe_NewCenturySchoolbookRoman_14px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_NewCenturySchoolbookRoman_14px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_NewCenturySchoolbookRoman_17px_BasicLatin = {
@@ -12838,6 +12842,7 @@ const struct font_t font_Adobe_NewCenturySchoolbookRoman_17px = {
     &unicode_block_Adobe_NewCenturySchoolbookRoman_17px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_NewCenturySchoolbookRoman_17px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_NewCenturySchoolbookRoman_18px_BasicLatin = {
@@ -15406,6 +15411,7 @@ const struct font_t font_Adobe_NewCenturySchoolbookRoman_18px = {
     &unicode_block_Adobe_NewCenturySchoolbookRoman_18px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_NewCenturySchoolbookRoman_18px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_NewCenturySchoolbookRoman_20px_BasicLatin = {
@@ -17975,6 +17981,7 @@ const struct font_t font_Adobe_NewCenturySchoolbookRoman_20px = {
 	&unicode_block_Adobe_NewCenturySchoolbookRoman_20px_Latin1Supplement
   },
   .unicode_blocks_count = 2,
+  .ascii = &unicode_block_Adobe_NewCenturySchoolbookRoman_20px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_NewCenturySchoolbookRoman_24px_BasicLatin = {
@@ -20543,6 +20550,7 @@ const struct font_t font_Adobe_NewCenturySchoolbookRoman_24px = {
     &unicode_block_Adobe_NewCenturySchoolbookRoman_24px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_NewCenturySchoolbookRoman_24px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_NewCenturySchoolbookRoman_25px_BasicLatin = {
@@ -23111,6 +23119,7 @@ const struct font_t font_Adobe_NewCenturySchoolbookRoman_25px = {
     &unicode_block_Adobe_NewCenturySchoolbookRoman_25px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_NewCenturySchoolbookRoman_25px_BasicLatin,
 };
 
 const struct glyph_unicode_block_t unicode_block_Adobe_NewCenturySchoolbookRoman_34px_BasicLatin = {
@@ -25679,4 +25688,5 @@ const struct font_t font_Adobe_NewCenturySchoolbookRoman_34px = {
     &unicode_block_Adobe_NewCenturySchoolbookRoman_34px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_NewCenturySchoolbookRoman_34px_BasicLatin,
 };
@@ -2566,4 +2566,5 @@ const struct font_t font_Adobe_NewCentuySchoolbookBold_12px = {
     &unicode_block_Adobe_NewCentuySchoolbookBold_12px_BasicLatin,
   },
   .unicode_blocks_count = 1,
+  .ascii = &unicode_block_Adobe_NewCentuySchoolbookBold_12px_BasicLatin,
 };
@@ -1,5 +1,6 @@
 #include "hal.h"
 #include <stdio.h>
+#include <string.h>
 #include "esp32_ili9341.h"
 
 void eglib_CommBegin(eglib_t *eglib) {
@@ -33,6 +34,39 @@ void eglib_Send(
 	}
 }
 
+void eglib_SendRepeat(
+	eglib_t *eglib,
+	enum hal_dc_t dc,
+	uint8_t *bytes,
+	uint32_t length,
+	uint32_t count
+) {
+	if(eglib->hal.driver->send_repeat == NULL) {
+		// replicate into a block and send that in chunks
+		uint8_t block[EGLIB_SEND_REPEAT_BLOCK];
+		uint32_t per_block = length ? sizeof(block) / length : 0;
+		if(per_block < 2) {
+			for(uint32_t i=0 ; i < count ; i++)
+				eglib_Send(eglib, dc, bytes, length);
+			return;
+		}
+		for(uint32_t i=0 ; i < per_block && i < count ; i++)
+			memcpy(block + i * length, bytes, length);
+		while(count) {
+			uint32_t n = count < per_block ? count : per_block;
+			eglib_Send(eglib, dc, block, n * length);
+			count -= n;
+		}
+		return;
+	}
+	// one send for the I2C slave address bookkeeping, then the rest in one go
+	if(count == 0)
+		return;
+	eglib_Send(eglib, dc, bytes, length);
+	if(count > 1)
+		eglib->hal.driver->send_repeat(eglib, dc, bytes, length, count - 1);
+}
+
 void eglib_CommEnd(eglib_t *eglib) {
 	// Send pending I2C Slave address
 	if(eglib->hal.i2c_send_slave_addr)
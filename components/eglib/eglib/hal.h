@@ -279,6 +279,15 @@ struct hal_struct {
 	 * :See also: :c:func:`eglib_CommEnd`.
 	 */
 	void (*comm_end)(eglib_t *eglib);
+	/**
+	 * Optional, sends the ``length`` bytes at ``bytes`` ``count`` times in a
+	 * row, e.g. the pixel of a fill. Drivers that can replay a pattern buffer
+	 * with DMA set this, when `NULL` :c:func:`eglib_SendRepeat` calls ``send``
+	 * in a loop.
+	 *
+	 * :See also: :c:func:`eglib_SendRepeat`.
+	 */
+	void (*send_repeat)(eglib_t *eglib, enum hal_dc_t dc, uint8_t *bytes, uint32_t length, uint32_t count);
 };
 
 /**
@@ -385,6 +394,30 @@ void eglib_Send(eglib_t *eglib, enum hal_dc_t dc, uint8_t *bytes, uint32_t lengt
 	eglib_SendData(eglib, &((uint8_t){bytes}), 1)\
 )
 
+#ifndef EGLIB_SEND_REPEAT_BLOCK
+#define EGLIB_SEND_REPEAT_BLOCK 512
+#endif
+
+/**
+ * Sends ``length`` bytes ``count`` times, like calling :c:func:`eglib_Send`
+ * ``count`` times with the same ``bytes``.
+ *
+ * Without a driver ``send_repeat``, the bytes are replicated into a block of
+ * :c:macro:`EGLIB_SEND_REPEAT_BLOCK` bytes on the stack and sent in chunks.
+ *
+ * :See also: :c:func:`hal_struct`.
+ */
+void eglib_SendRepeat(eglib_t *eglib, enum hal_dc_t dc, uint8_t *bytes, uint32_t length, uint32_t count);
+
+/**
+ * Sends the same data bytes ``count`` times.
+ *
+ * :See also: :c:func:`eglib_SendRepeat`.
+ */
+#define eglib_SendDataRepeat(eglib, bytes, length, count) (\
+	eglib_SendRepeat(eglib, HAL_DATA, bytes, length, count)\
+)
+
 /**
  * Sends commands.
  *
@@ -1,52 +1,153 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_system.h"
-#include "SPI.h"
+#include "esp_heap_caps.h"
+#include "driver/spi_master.h"
 #include "driver/gpio.h"
 #include <esp_log.h>
+#include <string.h>
+
+/*
+ * Display bus on the IDF spi_master driver.
+ *
+ * Sends are collected in one of two DMA capable buffers and queued as
+ * transactions that run in the background, the caller prepares the next
+ * region while the previous one is on the wire. Consecutive sends with the
+ * same D/C level are merged, so byte wise sends cost a memcpy, not a transfer.
+ * Fills replay a buffer with the replicated pattern (send_repeat).
+ * Anything that depends on the bus being idle (reset, delays, sleep) waits
+ * for the queue to drain first.
+ */
 
 extern "C" {
 #include "esp32_ili9341.h"
 
 static esp32_hal_config_t *config;
+static spi_device_handle_t spi = NULL;
+
+static spi_transaction_t trans[ESP32_ILI9341_QUEUE_LEN];
+static uint32_t queued = 0;      // transactions queued, the n-th one has sequence number n
+static uint32_t done = 0;        // transactions completed, always in queue order
+
+static uint8_t *chunk[2];        // double buffer for sends
+static uint32_t chunk_seq[2];    // last transaction that reads from the buffer
+static uint32_t chunk_len = 0;   // pending bytes in chunk[cur]
+static int cur = 0;
+static enum hal_dc_t chunk_dc;
+
+static uint8_t *fill;            // pattern replicated for send_repeat
+static uint32_t fill_seq = 0;
+static uint32_t fill_len = 0;    // valid bytes in fill, a multiple of the pattern length
+static uint8_t fill_pattern[4];
+static uint32_t fill_pattern_len = 0;
+
+static void IRAM_ATTR pre_transfer(spi_transaction_t *t) {
+	gpio_set_level(config->gpio_dc, (uint32_t)(uintptr_t)t->user);
+}
+
+// wait until transaction seq is off the wire
+static void reap(uint32_t seq) {
+	spi_transaction_t *t;
+	while( (int32_t)(seq - done) > 0 ){
+		ESP_ERROR_CHECK( spi_device_get_trans_result(spi, &t, portMAX_DELAY) );
+		done++;
+	}
+}
+
+static uint32_t queue(enum hal_dc_t dc, const uint8_t *bytes, uint32_t length) {
+	reap( queued + 1 - ESP32_ILI9341_QUEUE_LEN );  // free the oldest slot
+	spi_transaction_t *t = &trans[queued % ESP32_ILI9341_QUEUE_LEN];
+	memset(t, 0, sizeof(*t));
+	t->length = length * 8;
+	t->user = (void *)(uintptr_t)dc;
+	if( length <= 4 ){
+		t->flags = SPI_TRANS_USE_TXDATA;
+		memcpy(t->tx_data, bytes, length);
+	}
+	else
+		t->tx_buffer = bytes;
+	ESP_ERROR_CHECK( spi_device_queue_trans(spi, t, portMAX_DELAY) );
+	return ++queued;
+}
+
+static void flush() {
+	if( !chunk_len )
+		return;
+	uint32_t seq = queue(chunk_dc, chunk[cur], chunk_len);
+	if( chunk_len > 4 ){  // short ones were copied into the transaction, the buffer stays free
+		chunk_seq[cur] = seq;
+		cur ^= 1;
+	}
+	chunk_len = 0;
+}
+
+static void wait_idle() {
+	flush();
+	reap(queued);
+}
 
 static void einit(eglib_t *eglib) {
 	ESP_LOGI("ILI9341","init()");
 	config = (esp32_hal_config_t *)eglib_GetHalConfig(eglib);
-	SPI.begin( config->gpio_scl, config->gpio_sdo, config->gpio_sda, config->gpio_cs );  // done already by sensors and CS handled in here
-	// init GPIO pins of 4 WIRE SPI bus
-	gpio_reset_pin(config->gpio_cs);
+	// init GPIO pins of 4 WIRE SPI bus, CS is driven by the SPI peripheral
 	gpio_reset_pin(config->gpio_rs);
 	gpio_reset_pin(config->gpio_dc);
-	gpio_set_direction(config->gpio_cs, GPIO_MODE_OUTPUT);
 	gpio_set_direction(config->gpio_rs, GPIO_MODE_OUTPUT);
 	gpio_set_direction(config->gpio_dc, GPIO_MODE_OUTPUT);
 	// set default state for all output pins
 	gpio_set_level(config->gpio_rs, 1);
 	gpio_set_level(config->gpio_dc, 1 );
-	gpio_set_level(config->gpio_cs, 1 );
 
-	// hal_four_wire_spi_config_t * fwc = eglib_GetHalFourWireSpiConfigComm(eglib);
-	SPI.setClockDivider( SPI_CLOCK_DIV2 );
+	chunk[0] = (uint8_t *)heap_caps_malloc(ESP32_ILI9341_CHUNK_LEN, MALLOC_CAP_DMA);
+	chunk[1] = (uint8_t *)heap_caps_malloc(ESP32_ILI9341_CHUNK_LEN, MALLOC_CAP_DMA);
+	fill = (uint8_t *)heap_caps_malloc(ESP32_ILI9341_FILL_LEN, MALLOC_CAP_DMA);
+	if( !chunk[0] || !chunk[1] || !fill ){
+		ESP_LOGE("ILI9341","no DMA memory for SPI buffers");
+		ESP_ERROR_CHECK( ESP_ERR_NO_MEM );
+	}
+
+	spi_bus_config_t bus = {};
+	bus.mosi_io_num = config->gpio_sda;
+	bus.miso_io_num = config->gpio_sdo;
+	bus.sclk_io_num = config->gpio_scl;
+	bus.quadwp_io_num = -1;
+	bus.quadhd_io_num = -1;
+	bus.max_transfer_sz = ESP32_ILI9341_CHUNK_LEN > ESP32_ILI9341_FILL_LEN ? ESP32_ILI9341_CHUNK_LEN : ESP32_ILI9341_FILL_LEN;
+	ESP_ERROR_CHECK( spi_bus_initialize((spi_host_device_t)config->spi_num, &bus, SPI_DMA_CH_AUTO) );
+
+	spi_device_interface_config_t dev = {};
+	dev.mode = config->dataMode;
+	dev.clock_speed_hz = config->freq;
+	dev.spics_io_num = config->gpio_cs;
+	dev.queue_size = ESP32_ILI9341_QUEUE_LEN;
+	dev.pre_cb = pre_transfer;
+	if( config->bitOrder == ESP32_ILI9341_LSBFIRST )
+		dev.flags = SPI_DEVICE_BIT_LSBFIRST;
+	ESP_ERROR_CHECK( spi_bus_add_device((spi_host_device_t)config->spi_num, &dev, &spi) );
+	ESP_LOGI("ILI9341","SPI%d at %d Hz, DMA", config->spi_num+1, config->freq );
 }
 
 static void esleep_in(eglib_t *_eglib) {
 	ESP_LOGI("ILI9341","sleep in");
+	wait_idle();
 	vTaskDelay( 120 / portTICK_PERIOD_MS);
 }
 
 static void esleep_out(eglib_t *_eglib) {
 	ESP_LOGI("ILI9341","sleep out");
+	wait_idle();
 	vTaskDelay( 120 / portTICK_PERIOD_MS);
 }
 
 static void edelay_ns(eglib_t *_eglib, uint32_t ns) {
 	ESP_LOGI("ILI9341","delay %d ms", ns/1000000 );
+	wait_idle();  // delays are timed from the last command sent
 	vTaskDelay( (ns/1000000) / portTICK_PERIOD_MS);
 }
 
 static void eset_reset(eglib_t *_eglib, bool state) {
 	ESP_LOGI("ILI9341","reset IO:%d state=%d", config->gpio_rs, state );
+	wait_idle();
 	gpio_set_level(config->gpio_rs, (unsigned int)state );
 }
 
@@ -55,9 +156,7 @@ static bool eget_busy(eglib_t *_eglib) {
 }
 
 static void ecomm_begin(eglib_t *_eglib) {
-	// ESP_LOGI("ILI9341", "comm begin(): eglib:%x config:%x CS-PIN:%d", (unsigned int)_eglib, (unsigned int)config, (unsigned int)config->gpio_cs );
-	gpio_set_level(config->gpio_cs, 0 );
-	SPI.beginTransaction(SPISettings( config->freq, config->bitOrder, config->dataMode ));  // *3
+	// the display is the only device on its bus, CS is asserted per transaction
 }
 
 void esend(
@@ -67,20 +166,57 @@ void esend(
 	uint32_t length )
 {
 	// ESP_LOGI("ILI9341", "esend() DC-IO:%d dc:%s len:%d\n",config->gpio_dc,  dc?"DAT":"CMD", length );
-    // ESP_LOG_BUFFER_HEXDUMP("ILI9341", bytes, length, ESP_LOG_INFO);
-    if( dc == HAL_DATA ){
-    	gpio_set_level(config->gpio_dc, 1 );
-    }
-    else{
-    	gpio_set_level(config->gpio_dc, 0 );
-    }
-	SPI.transfer( bytes, length );
+	if( chunk_len && dc != chunk_dc )
+		flush();
+	while( length ){
+		if( !chunk_len ){
+			reap( chunk_seq[cur] );  // DMA may still read the buffer
+			chunk_dc = dc;
+		}
+		uint32_t n = ESP32_ILI9341_CHUNK_LEN - chunk_len;
+		if( n > length )
+			n = length;
+		memcpy( chunk[cur] + chunk_len, bytes, n );
+		chunk_len += n;
+		bytes += n;
+		length -= n;
+		if( chunk_len == ESP32_ILI9341_CHUNK_LEN )
+			flush();
+	}
+}
+
+static void esend_repeat(
+	eglib_t *_eglib,
+	enum hal_dc_t dc,
+	uint8_t *bytes,
+	uint32_t length,
+	uint32_t count )
+{
+	uint32_t total = length * count;
+	if( length > sizeof(fill_pattern) || total < ESP32_ILI9341_FILL_MIN ){
+		for( uint32_t i=0; i < count; i++ )
+			esend( _eglib, dc, bytes, length );
+		return;
+	}
+	flush();
+	if( length != fill_pattern_len || memcmp( bytes, fill_pattern, length ) ){
+		reap( fill_seq );
+		fill_len = ESP32_ILI9341_FILL_LEN - ESP32_ILI9341_FILL_LEN % length;
+		for( uint32_t i=0; i < fill_len; i += length )
+			memcpy( fill + i, bytes, length );
+		memcpy( fill_pattern, bytes, length );
+		fill_pattern_len = length;
+	}
+	while( total ){
+		uint32_t n = total > fill_len ? fill_len : total;
+		fill_seq = queue( dc, fill, n );
+		total -= n;
+	}
 }
 
 static void ecomm_end(eglib_t *_eglib) {
 	// ESP_LOGI("ILI9341","comm end()");
-	SPI.endTransaction();
-	gpio_set_level(config->gpio_cs, 1 );
+	flush();  // queued, not waited for
 }
 
 hal_t esp32_ili9341 = {
@@ -93,5 +229,6 @@ hal_t esp32_ili9341 = {
 	.comm_begin = ecomm_begin,
 	.send = esend,
 	.comm_end = ecomm_end,
+	.send_repeat = esend_repeat,
 };
 }
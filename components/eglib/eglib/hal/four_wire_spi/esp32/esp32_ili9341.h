@@ -8,6 +8,8 @@
 /**
  * 4-Wire SPI HAL driver for ESP32 ILI9341 four wire SPI IPS display module
  *
+ * Uses the IDF spi_master driver with DMA, transfers are queued and run in
+ * the background. The display must be the only device on the SPI host.
  *
  * :See also: :c:func:`eglib_Init`.
  */
@@ -18,6 +20,23 @@
 
 extern hal_t esp32_ili9341;
 
+// queued SPI transactions
+#ifndef ESP32_ILI9341_QUEUE_LEN
+#define ESP32_ILI9341_QUEUE_LEN 8
+#endif
+// size of each of the two DMA send buffers
+#ifndef ESP32_ILI9341_CHUNK_LEN
+#define ESP32_ILI9341_CHUNK_LEN 2048
+#endif
+// DMA buffer holding the replicated pattern of fills, a multiple of 2, 3 and 4
+#ifndef ESP32_ILI9341_FILL_LEN
+#define ESP32_ILI9341_FILL_LEN 1536
+#endif
+// shorter fills are copied to the send buffer
+#define ESP32_ILI9341_FILL_MIN 64
+
+#define ESP32_ILI9341_LSBFIRST 0   // bitOrder, as Arduino's LSBFIRST
+
 typedef struct esp32_hal_config{
 	uint8_t spi_num;
 	uint32_t freq;
@@ -215,7 +215,7 @@ int main(int argc, char *argv[]) {
 		);
 
 	printf("\n");
-	printf("struct font_t font_%s = {\n", font_name);
+	printf("const struct font_t font_%s = {\n", font_name);
 	printf("  .pixel_size = %d,\n", pixel_size);
 	printf("  .ascent = %ld,\n", face->size->metrics.ascender >> 6);
 	printf("  .descent = %ld,\n", face->size->metrics.descender >> 6);
@@ -224,5 +224,7 @@ int main(int argc, char *argv[]) {
 	printf("    &unicode_block_%s_%s,\n", font_name, unicode_block_name[0]);
 	printf("  },\n");
 	printf("  .unicode_blocks_count = 1,\n");
+	if(charcode_start[0] <= 0x20 && charcode_end[0] >= 0x7e)
+		printf("  .ascii = &unicode_block_%s_%s,\n", font_name, unicode_block_name[0]);
 	printf("};\n");
 }
\ No newline at end of file
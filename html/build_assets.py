@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+#
+# Prepares the web assets for embedding, see html/CMakeLists.txt:
+#
+#   - index.html is minified: comments, indentation and blank lines go
+#   - references to the other assets get "?v=<etag>", so these can be
+#     cached as immutable and still change with the next firmware
+#   - with --gzip, each asset is written as <name>.gz (reproducible, mtime 0)
+#   - <name>.etag holds the quoted ETag of the served bytes
+#
+#   build_assets.py [--gzip] <outdir> html/milligram.min.css html/index.html
+#
+
+import argparse
+import gzip
+import hashlib
+import io
+import os
+import re
+
+
+def minify_html(text):
+    text = re.sub(r"<!--(?!\[).*?-->", "", text, flags=re.S)
+    text = re.sub(r"(<style[^>]*>)(.*?)(</style>)",
+                  lambda m: m.group(1) + re.sub(r"/\*.*?\*/", "", m.group(2), flags=re.S) + m.group(3),
+                  text, flags=re.S)
+    out = []
+    in_script = False
+    for line in text.splitlines():
+        line = line.strip()
+        if re.search(r"<script\b", line):
+            in_script = True
+        if re.search(r"</script>", line):
+            in_script = False
+        if not line or (in_script and line.startswith("//")):
+            continue
+        out.append(line)
+    return "\n".join(out) + "\n"
+
+
+def compress(data):
+    buf = io.BytesIO()
+    with gzip.GzipFile(fileobj=buf, mode="wb", compresslevel=9, mtime=0) as f:
+        f.write(data)
+    return buf.getvalue()
+
+
+def etag(data):
+    return '"' + hashlib.sha256(data).hexdigest()[:16] + '"'
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Minify, compress and tag the embedded web assets")
+    parser.add_argument("--gzip", action="store_true", help="write <name>.gz for embedding")
+    parser.add_argument("outdir")
+    parser.add_argument("assets", nargs="+", help="html files last, they may refer to the others")
+    args = parser.parse_args()
+
+    os.makedirs(args.outdir, exist_ok=True)
+    versions = {}
+    for path in sorted(args.assets, key=lambda p: p.endswith(".html")):
+        name = os.path.basename(path)
+        with open(path, "rb") as f:
+            data = f.read()
+        if name.endswith(".html"):
+            text = minify_html(data.decode())
+            for ref, tag in versions.items():
+                text = re.sub(r'((?:href|src)=")%s"' % re.escape(ref), r'\g<1>%s?v=%s"' % (ref, tag), text)
+            data = text.encode()
+        served = compress(data) if args.gzip else data
+        out = os.path.join(args.outdir, name + (".gz" if args.gzip else ""))
+        with open(out, "wb") as f:
+            f.write(served)
+        tag = etag(served)
+        with open(os.path.join(args.outdir, name + ".etag"), "w") as f:
+            f.write(tag)
+        versions[name] = tag.strip('"')
+        print(f"Asset {name}: {len(data)} > {len(served)} bytes, ETag {tag}")
@@ -5,6 +5,7 @@
 #include "logdef.h"
 #include "SetupNG.h"
 #include "Colors.h"
+#include <new>
 
 #define HSPI 2
 
@@ -46,7 +47,7 @@ uint8_t PROGMEM eglib_font_free_sansbold_66[] = { EGLIB_FONT_FREE_SANSBOLD_66 };
 static ili9341_config_t ili9341_config = {
 		.width = DISPLAY_W,
 		.height = DISPLAY_H,
-		.color = ILI9341_COLOR_18_BIT,
+		.color = ILI9341_COLOR_16_BIT,   // RGB565, 2 bytes per pixel on the bus
 		.page_address = ILI9341_PAGE_ADDRESS_TOP_TO_BOTTOM,
 		.colum_address = ILI9341_COLUMN_ADDRESS_LEFT_TO_RIGHT,
 		.page_column_order = ILI9341_PAGE_COLUMN_ORDER_NORMAL,
@@ -68,93 +69,235 @@ static PROGMEM esp32_hal_config_t esp32_ili9341_config = {
 };
 
 void AdaptUGC::setFont(uint8_t *f, bool filled ){    // adapter
-	eglib_setFilledMode( eglib, filled );
+	const struct font_t *font = nullptr;
 	switch( f[0] ){
 	case UCG_FONT_9x15B_MF:
-		eglib_SetFont(eglib, &font_FreeFont_FreeMonoBold_15px);
+		font = &font_FreeFont_FreeMonoBold_15px;
 		break;
 	case UCG_FONT_NCENR14_HR:
-		eglib_SetFont(eglib, &font_Adobe_NewCenturySchoolbookRoman_20px);
+		font = &font_Adobe_NewCenturySchoolbookRoman_20px;
 		break;
 	case UCG_FONT_FUB11_TR:
-		eglib_SetFont(eglib, &font_Adobe_HelveticaBold_17px);
+		font = &font_Adobe_HelveticaBold_17px;
 		break;
 	case UCG_FONT_FUB11_HN:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_18px);
+		font = &font_FreeFont_FreeSansBold_18px;
 		break;
 	case UCG_FONT_FUB11_HR:
-		eglib_SetFont(eglib, &font_Adobe_HelveticaBold_17px);
+		font = &font_Adobe_HelveticaBold_17px;
 		break;
 	case UCG_FONT_FUB14_HN:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_18px);
+		font = &font_FreeFont_FreeSansBold_18px;
 		break;
 	case UCG_FONT_FUB14_HR:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_20px);
+		font = &font_FreeFont_FreeSansBold_20px;
 		break;
 	case UCG_FONT_FUB14_HF:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_20px);
+		font = &font_FreeFont_FreeSansBold_20px;
 		break;
 	case UCG_FONT_FUR14_HF:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSans_20px);
+		font = &font_FreeFont_FreeSans_20px;
 		break;
 	case UCG_FONT_FUB17_HF:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_24px);
+		font = &font_FreeFont_FreeSansBold_24px;
 		break;
 	case UCG_FONT_FUB20_HN:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_28px);
+		font = &font_FreeFont_FreeSansBold_28px;
 		break;
 	case UCG_FONT_FUB20_HR:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_28px);
+		font = &font_FreeFont_FreeSansBold_28px;
 		break;
 	case UCG_FONT_FUB20_HF:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_28px);
+		font = &font_FreeFont_FreeSansBold_28px;
 		break;
 	case UCG_FONT_FUB25_HR:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_32px);
+		font = &font_FreeFont_FreeSansBold_32px;
 		break;
 	case UCG_FONT_FUB25_HF:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_32px);
+		font = &font_FreeFont_FreeSansBold_32px;
 		break;
 	case UCG_FONT_FUR25_HF:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_32px);
+		font = &font_FreeFont_FreeSansBold_32px;
 		break;
 	case UCG_FONT_FUB25_HN:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_32px);
+		font = &font_FreeFont_FreeSansBold_32px;
 		break;
 	case UCG_FONT_FUB35_HN:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_48px);
+		font = &font_FreeFont_FreeSansBold_48px;
 		break;
 	case UCG_FONT_FUB35_HR:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_48px);
+		font = &font_FreeFont_FreeSansBold_48px;
 		break;
 	case EGLIB_FONT_FREE_SANSBOLD_66:
-                eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_66px);
-                break;
+		font = &font_FreeFont_FreeSansBold_66px;
+		break;
 	case UCG_FONT_PROFONT22_MR:
-		eglib_SetFont(eglib, &font_FreeFont_FreeMonoBold_20px);
+		font = &font_FreeFont_FreeMonoBold_20px;
 		break;
 	default:
 		printf("No Font found !\n");
+		return;
+	}
+	measure.drawing.font = font;
+	if( back ){
+		t_dl_cmd c = {};
+		c.op = DL_FONT;
+		c.opt = filled;
+		c.font = font;
+		append( c );
+	}
+	else{
+		eglib_setFilledMode( eglib, filled );
+		eglib_SetFont( eglib, font );
 	}
 };
 
+void AdaptUGC::setIndexColor( uint8_t idx, uint8_t r, uint8_t g, uint8_t b ){
+	if( back ){
+		t_dl_cmd c = {};
+		c.op = DL_COLOR;
+		c.opt = idx;
+		c.color.r = r; c.color.g = g; c.color.b = b;
+		append( c );
+	}
+	else
+		eglib_SetIndexColor( eglib, idx, r, g, b );
+}
+
+void AdaptUGC::setFontOrigin( e_font_origin origin ){
+	if( back )
+		record( DL_FONT_ORIGIN, origin );
+	else
+		eglib_setFontOrigin( eglib, origin );
+}
+
 #define EGL_DISPLAY_TOPDOWN 1
 #define EGL_WHITE_ON_BLACK 1
 
-void  AdaptUGC::begin() {
-	eglib = &myeglib;
-
+void  AdaptUGC::begin( bool retained ) {
 	if( display_orientation.get() == DISPLAY_TOPDOWN ){
 		ili9341_config.page_address =  ILI9341_PAGE_ADDRESS_BOTTOM_TO_TOP;
 		ili9341_config.colum_address = ILI9341_COLUMN_ADDRESS_RIGHT_TO_LEFT;
 	}
 	setRedBlueTwist(true);
 	invertDisplay(true);
-	ESP_LOGI(FNAME, "eglib_Send() &eglib:%x  hal-driv:%x config:%x\n", (unsigned int)eglib, (unsigned int)&esp32_ili9341, (unsigned int)&esp32_ili9341_config );
-	eglib_Init( &myeglib, &esp32_ili9341, &esp32_ili9341_config, &ili9341, &ili9341_config );
+	ESP_LOGI(FNAME, "eglib_Send() &eglib:%x  hal-driv:%x config:%x\n", (unsigned int)&myeglib, (unsigned int)&esp32_ili9341, (unsigned int)&esp32_ili9341_config );
+	begin( &esp32_ili9341, &esp32_ili9341_config, &ili9341, &ili9341_config, retained );
+};
+
+// any eglib backend, the host screen tests (tools/test) draw to an emulated panel
+void AdaptUGC::begin( const hal_t *hal, void *hal_config, const display_t *display, void *display_config, bool retained ) {
+	eglib = &myeglib;
+	eglib_Init( &myeglib, hal, hal_config, display, display_config );
+	// glyph scratch buffer for the largest font in use, smaller ones render into it without heap churn
+	eglib_ReserveGlyphBuffer( eglib, &font_FreeFont_FreeSansBold_32px );
 	setClipRange( 0,0, 240, 320 );
+	measure = myeglib;
+	if( !retained )
+		return;
+	DisplayList *lists = new (std::nothrow) DisplayList[2];
+	listLock = xSemaphoreCreateMutex();
+	frameDone = xSemaphoreCreateBinary();
+	if( !lists || !listLock || !frameDone ){
+		ESP_LOGW(FNAME, "No memory for display lists, drawing directly");
+		delete [] lists;
+		return;
+	}
+	front = &lists[0];
+	back = &lists[1];
+	xTaskCreatePinnedToCore(&displayTask, "display", 4096, this, 10, &displayPid, 0);
+	ESP_LOGI(FNAME, "Retained display, %d bytes per list", sizeof(DisplayList) );
 };
 
+// records a draw or state change with plain coordinates
+void AdaptUGC::record( uint8_t op, uint8_t opt, int16_t a0, int16_t a1, int16_t a2, int16_t a3,
+		int16_t a4, int16_t a5, int16_t a6, int16_t a7 ){
+	t_dl_cmd c;
+	c.op = op;
+	c.opt = opt;
+	c.a[0] = a0; c.a[1] = a1; c.a[2] = a2; c.a[3] = a3;
+	c.a[4] = a4; c.a[5] = a5; c.a[6] = a6; c.a[7] = a7;
+	append( c );
+}
+
+// frameDone wakes one waiter per frame, any other one sees the state after FRAME_WAIT
+#define FRAME_WAIT (20/portTICK_PERIOD_MS)
+
+// a full list goes to the display early, if it is still busy with the last one we wait
+void AdaptUGC::append( const t_dl_cmd &cmd, const char *text, size_t len ){
+	xSemaphoreTake( listLock, portMAX_DELAY );
+	while( !back->add( cmd, text, len ) ){
+		if( back->empty() ){   // text larger than a list, never fits
+			ESP_LOGW(FNAME, "Text of %u bytes dropped", (unsigned)len );
+			break;
+		}
+		if( busy ){
+			xSemaphoreGive( listLock );
+			xSemaphoreTake( frameDone, FRAME_WAIT );
+			xSemaphoreTake( listLock, portMAX_DELAY );
+		}
+		else
+			swap();
+	}
+	xSemaphoreGive( listLock );
+}
+
+// hands the recorded list to the display task, listLock held and display idle
+void AdaptUGC::swap(){
+	DisplayList *l = front;
+	front = back;
+	back = l;
+	busy = true;
+	pending = false;
+	xTaskNotifyGive( displayPid );
+}
+
+void AdaptUGC::commit(){
+	if( !back )
+		return;
+	xSemaphoreTake( listLock, portMAX_DELAY );
+	if( !back->empty() ){
+		if( busy )
+			pending = true;   // the display task takes it when done
+		else
+			swap();
+	}
+	xSemaphoreGive( listLock );
+}
+
+void AdaptUGC::sync(){
+	if( !back )
+		return;
+	while( true ){
+		xSemaphoreTake( listLock, portMAX_DELAY );
+		if( !busy && !back->empty() )
+			swap();   // also what was recorded after a frame had just finished
+		bool idle = !busy && back->empty();
+		xSemaphoreGive( listLock );
+		if( idle )
+			break;
+		xSemaphoreTake( frameDone, FRAME_WAIT );
+	}
+}
+
+void AdaptUGC::displayTask( void *arg ){
+	AdaptUGC *u = (AdaptUGC *)arg;
+	while( true ){
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+		u->front->cull( u->eglib );
+		u->front->run( u->eglib );
+		ESP_LOGD(FNAME, "Frame %d commands, %d culled", u->front->size(), u->front->culled() );
+		u->front->clear();
+		xSemaphoreTake( u->listLock, portMAX_DELAY );
+		u->busy = false;
+		if( u->pending && !u->back->empty() )
+			u->swap();
+		u->pending = false;
+		xSemaphoreGive( u->listLock );
+		xSemaphoreGive( u->frameDone );
+	}
+}
+
 void AdaptUGC::advanceCursor( size_t delta ){
 	switch(eglib_print_dir) {
 	case UCG_PRINT_DIR_LR:
@@ -164,53 +307,61 @@ void AdaptUGC::advanceCursor( size_t delta ){
 		eglib_print_xpos -= delta;
 		break;
 	case UCG_PRINT_DIR_TD:
-		delta = eglib->drawing.font->ascent - eglib->drawing.font->descent;
+		delta = measure.drawing.font->ascent - measure.drawing.font->descent;
 		eglib_print_ypos += delta;
 		break;
 	default: case UCG_PRINT_DIR_BU:
-		delta = eglib->drawing.font->ascent - eglib->drawing.font->descent;
+		delta = measure.drawing.font->ascent - measure.drawing.font->descent;
 		eglib_print_ypos -= delta;
 	}
 	// ESP_LOGI(FNAME, "advanceCursor() delta: %d newc:%d", delta,  eglib_print_xpos );
 }
 
 size_t AdaptUGC::write(const uint8_t *buffer, size_t size){
-	size_t delta = eglib_DrawText(eglib, eglib_print_xpos, eglib_print_ypos, (const char *)buffer );
+	size_t delta;
+	if( back ){
+		t_dl_cmd c = {};
+		c.op = DL_TEXT;
+		c.a[0] = eglib_print_xpos;
+		c.a[1] = eglib_print_ypos;
+		append( c, (const char *)buffer, size );
+		delta = eglib_GetTextWidth( &measure, (const char *)buffer );
+	}
+	else
+		delta = eglib_DrawText(eglib, eglib_print_xpos, eglib_print_ypos, (const char *)buffer );
 	advanceCursor( delta );
 	return size;
 }
 
 size_t AdaptUGC::write(uint8_t c) {
-	size_t delta = 0;
+	const struct font_t *font = measure.drawing.font;
+	int16_t ypos;
 	switch (eglib_font_pos) {
-	case UCG_FONT_POS_BOTTOM: {
-		const struct font_t *font;
-		font = eglib->drawing.font;
-		int16_t ypos = eglib_print_ypos + font->descent; // descent is negativ value!
-		delta = eglib_DrawWChar(eglib, eglib_print_xpos, ypos, wchar_t (c));
+	case UCG_FONT_POS_BOTTOM:
+		ypos = eglib_print_ypos + font->descent; // descent is negativ value!
 		break;
-	}
-	case UCG_FONT_POS_CENTER: {
-		const struct font_t *font;
-		font = eglib->drawing.font;
-		int16_t ypos = eglib_print_ypos+(font->ascent/2)+(font->descent);
-		delta = eglib_DrawWChar(eglib, eglib_print_xpos, ypos, wchar_t (c));
+	case UCG_FONT_POS_CENTER:
+		ypos = eglib_print_ypos+(font->ascent/2)+(font->descent);
 		break;
-	}
-	case UCG_FONT_POS_TOP: {
-		const struct font_t *font;
-		font = eglib->drawing.font;
-		int16_t ypos = eglib_print_ypos+font->ascent;
-		delta = eglib_DrawWChar(eglib, eglib_print_xpos, ypos, wchar_t (c));
+	case UCG_FONT_POS_TOP:
+		ypos = eglib_print_ypos+font->ascent;
 		break;
-	}
-	default: case UCG_FONT_POS_BASE: {
-		delta = eglib_DrawWChar(eglib, eglib_print_xpos, eglib_print_ypos, wchar_t (c));
+	default: case UCG_FONT_POS_BASE:
+		ypos = eglib_print_ypos;
 		break;
 	}
+	size_t delta;
+	if( back ){
+		record( DL_WCHAR, 0, eglib_print_xpos, ypos, c );
+		const struct glyph_t *glyph = eglib_GetGlyph( &measure, wchar_t (c) );
+		if( glyph )
+			delta = glyph->advance;
+		else
+			delta = ( c == 0x0a || c == 0x0d ) ? 0 : font->pixel_size;  // as drawn for a missing glyph
 	}
+	else
+		delta = eglib_DrawWChar(eglib, eglib_print_xpos, ypos, wchar_t (c));
 	advanceCursor( delta );
 	return 1;
 };
 
-
@@ -4,6 +4,10 @@ extern "C" {
 #include "inttypes.h"
 #include "Arduino.h"
 #include "Colors.h"
+#include "DisplayList.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
 
 #pragma once
 
@@ -84,67 +88,87 @@ extern uint8_t ucg_font_fub11_hn[];
 extern uint8_t eglib_font_free_sansbold_66[];
 
 
+// In retained mode, begin( true ), drawing calls are recorded into a display list
+// and a display task culls overdraw and executes them on the panel. A frame is
+// handed over with commit(), recording goes on into the second list meanwhile.
 class AdaptUGC : public Print{
 public:
 	// init
-	void begin();
+	void begin( bool retained=false );
+	void begin( const hal_t *hal, void *hal_config, const display_t *display, void *display_config, bool retained=false );
 	void invertDisplay( bool inv ) {invertDisp=inv;};  	        // solved in grafic layer
 	void setRedBlueTwist( bool twist ) {twistRB= twist;};   	    // no more needed, type of displays phased out
-	inline void undoClipRange() { eglib_undoClipRange(eglib);};
+	inline void undoClipRange() { if( back ) record( DL_UNCLIP ); else eglib_undoClipRange(eglib);};
+	inline bool retained() const { return back != nullptr; }
+	void commit();                                                   // end of frame, no-op if not retained
+	void sync();                                                     // commit and wait until all is on the panel
 	// color
 	inline void setColor( uint8_t idx, uint8_t r, uint8_t g, uint8_t b ) {
 		twistRB?
-				eglib_SetIndexColor(eglib, idx, invertDisp?~b:b, invertDisp?~g:g, invertDisp?~r:r):
-				eglib_SetIndexColor(eglib, idx, invertDisp?~r:r, invertDisp?~g:g, invertDisp?~b:b);
-	}
-	inline void setColor( uint8_t r, uint8_t g, uint8_t b ) {
-		twistRB?
-				eglib_SetIndexColor(eglib, 0, invertDisp?~b:b, invertDisp?~g:g, invertDisp?~r:r):
-				eglib_SetIndexColor(eglib, 0, invertDisp?~r:r, invertDisp?~g:g, invertDisp?~b:b);
+				setIndexColor(idx, invertDisp?~b:b, invertDisp?~g:g, invertDisp?~r:r):
+				setIndexColor(idx, invertDisp?~r:r, invertDisp?~g:g, invertDisp?~b:b);
 	}
+	inline void setColor( uint8_t r, uint8_t g, uint8_t b ) { setColor( 0, r, g, b ); }
 	// graphics
-	inline void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1)  { eglib_DrawLine(eglib, x0, y0, x1, y1); }
-	inline void drawBox(int16_t x, int16_t y, int16_t w, int16_t h)  { eglib_DrawBox(eglib, x, y, w, h); }
-	inline void drawFrame(int16_t x, int16_t y, int16_t w, int16_t h)  { eglib_DrawFrame(eglib, x, y, w, h); }
-	inline void drawHLine(int16_t x, int16_t y, int16_t len)  { eglib_DrawHLine(eglib, x, y, len); }
-	inline void drawVLine(int16_t x, int16_t y, int16_t len)  { eglib_DrawVLine(eglib, x, y, len); }
-	inline void drawPixel(int16_t x, int16_t y)  { eglib_DrawPixel(eglib, x, y); }
-	inline void drawRBox(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r)  { eglib_DrawRoundBox(eglib, x, y, w, h, r); }
-	inline void drawRFrame(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r)  { eglib_DrawRoundFrame(eglib, x, y, w, h, r); }
-	inline void drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2)  { eglib_DrawFilledTriangle(eglib, x0, y0, x1, y1, x2, y2); }
-	inline void drawTetragon(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, int16_t x3, int16_t y3)  { eglib_DrawTetragon(eglib, x0, y0, x1, y1, x2, y2, x3, y3); }
-	inline void drawCircle(int16_t x, int16_t y, int16_t radius, uint8_t options=EGLIB_DRAW_ALL){ eglib_DrawCircle(eglib, x, y, radius, options); }
-	inline void drawDisc(int16_t x, int16_t y, int16_t radius, uint8_t options){	eglib_DrawDisc(eglib, x, y, radius, options);	}
+	inline void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1)  { if( back ) record( DL_LINE, 0, x0, y0, x1, y1 ); else eglib_DrawLine(eglib, x0, y0, x1, y1); }
+	inline void drawBox(int16_t x, int16_t y, int16_t w, int16_t h)  { if( back ) record( DL_BOX, 0, x, y, w, h ); else eglib_DrawBox(eglib, x, y, w, h); }
+	inline void drawFrame(int16_t x, int16_t y, int16_t w, int16_t h)  { if( back ) record( DL_FRAME, 0, x, y, w, h ); else eglib_DrawFrame(eglib, x, y, w, h); }
+	inline void drawHLine(int16_t x, int16_t y, int16_t len)  { drawLine( x, y, x + len, y ); }
+	inline void drawVLine(int16_t x, int16_t y, int16_t len)  { drawLine( x, y, x, y + len ); }
+	inline void drawPixel(int16_t x, int16_t y)  { if( back ) record( DL_PIXEL, 0, x, y ); else eglib_DrawPixel(eglib, x, y); }
+	inline void drawRBox(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r)  { if( back ) record( DL_RBOX, 0, x, y, w, h, r ); else eglib_DrawRoundBox(eglib, x, y, w, h, r); }
+	inline void drawRFrame(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r)  { if( back ) record( DL_RFRAME, 0, x, y, w, h, r ); else eglib_DrawRoundFrame(eglib, x, y, w, h, r); }
+	inline void drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2)  { if( back ) record( DL_TRIANGLE, 0, x0, y0, x1, y1, x2, y2 ); else eglib_DrawFilledTriangle(eglib, x0, y0, x1, y1, x2, y2); }
+	inline void drawTetragon(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, int16_t x3, int16_t y3)  { if( back ) record( DL_TETRAGON, 0, x0, y0, x1, y1, x2, y2, x3, y3 ); else eglib_DrawTetragon(eglib, x0, y0, x1, y1, x2, y2, x3, y3); }
+	inline void drawCircle(int16_t x, int16_t y, int16_t radius, uint8_t options=EGLIB_DRAW_ALL){ if( back ) record( DL_CIRCLE, options, x, y, radius ); else eglib_DrawCircle(eglib, x, y, radius, options); }
+	inline void drawDisc(int16_t x, int16_t y, int16_t radius, uint8_t options){ if( back ) record( DL_DISC, options, x, y, radius ); else eglib_DrawDisc(eglib, x, y, radius, options);	}
 
 	// Text Printing
 	size_t write(uint8_t c);
 	size_t write(const uint8_t *buffer, size_t size);
 	inline void setPrintPos(int16_t x, int16_t y) { eglib_print_xpos = x; eglib_print_ypos = y; };
 	inline void setPrintDir(uint8_t d) { eglib_print_dir = d; }
-	inline int16_t getStrWidth( const char * s ) { return ( eglib_GetTextWidth(eglib, s) ); };
+	inline int16_t getStrWidth( const char * s ) { return ( eglib_GetTextWidth(&measure, s) ); };
 	// Font related
 	void setFont(uint8_t *f, bool filled=false );
 	void setFontMode( uint8_t is_transparent ) {};  // no concept for transparent fonts in eglib, as it appears
-	inline void setFontPosBottom() {  eglib_setFontOrigin( eglib, FONT_BOTTOM ); };
-	inline void setFontPosCenter() {   eglib_setFontOrigin( eglib, FONT_MIDDLE ); };
-	inline int16_t getFontAscent() { const struct font_t *font; font = eglib->drawing.font;  return font->ascent;  };
-	inline int16_t getFontDescent() { const struct font_t *font; font = eglib->drawing.font; return font->descent; };
+	inline void setFontPosBottom() { setFontOrigin( FONT_BOTTOM ); };
+	inline void setFontPosCenter() { setFontOrigin( FONT_MIDDLE ); };
+	inline int16_t getFontAscent() { const struct font_t *font; font = measure.drawing.font;  return font->ascent;  };
+	inline int16_t getFontDescent() { const struct font_t *font; font = measure.drawing.font; return font->descent; };
 
 	// scrolling, clipping, clear
-	inline void clearScreen() { setColor( COLOR_BLACK ); eglib_ClearScreen( eglib ); };
-	inline void scrollLines(int16_t lines) {  eglib_scrollScreen( eglib, lines ); };     	    // display driver function  tbd.
-	inline void scrollSetMargins( int16_t top, int16_t bottom ) { eglib_setScrollMargins( eglib, top, bottom ); };                 // display driver function
-	inline void setClipRange( int16_t x, int16_t y, int16_t w, int16_t h ) { eglib_setClipRange(eglib, x, y, w, h );};
+	inline void clearScreen() { setColor( COLOR_BLACK ); if( back ) record( DL_CLEAR ); else eglib_ClearScreen( eglib ); };
+	inline void scrollLines(int16_t lines) { if( back ) record( DL_SCROLL, 0, lines ); else eglib_scrollScreen( eglib, lines ); };     	    // display driver function  tbd.
+	inline void scrollSetMargins( int16_t top, int16_t bottom ) { if( back ) record( DL_SCROLL_MARGINS, 0, top, bottom ); else eglib_setScrollMargins( eglib, top, bottom ); };                 // display driver function
+	inline void setClipRange( int16_t x, int16_t y, int16_t w, int16_t h ) { if( back ) record( DL_CLIP, 0, x, y, w, h ); else eglib_setClipRange(eglib, x, y, w, h );};
 
 private:
 	inline void advanceCursor( size_t delta );
+	void setIndexColor( uint8_t idx, uint8_t r, uint8_t g, uint8_t b );
+	void setFontOrigin( e_font_origin origin );
+	void record( uint8_t op, uint8_t opt=0, int16_t a0=0, int16_t a1=0, int16_t a2=0, int16_t a3=0,
+			int16_t a4=0, int16_t a5=0, int16_t a6=0, int16_t a7=0 );
+	void append( const t_dl_cmd &cmd, const char *text=nullptr, size_t len=0 );
+	void swap();
+	static void displayTask( void *arg );
 
 	int16_t eglib_print_xpos = 0, eglib_print_ypos = 0;
 	int8_t eglib_font_pos = UCG_FONT_POS_BOTTOM;
 	uint8_t eglib_print_dir = UCG_PRINT_DIR_LR;
 	eglib_t * eglib;
+	eglib_t measure;                  // font only, text metrics without touching the display state
 	bool twistRB;
 	bool invertDisp;
+
+	// retained mode
+	DisplayList *front = nullptr;     // executed by the display task
+	DisplayList *back = nullptr;      // recorded into, nullptr: direct mode
+	bool busy = false;                // front handed over, not yet drawn
+	bool pending = false;             // commit() while busy
+	SemaphoreHandle_t listLock = 0;
+	SemaphoreHandle_t frameDone = 0;
+	TaskHandle_t displayPid = 0;
 };
 
 extern AdaptUGC *egl;
@@ -0,0 +1,51 @@
+/*
+ * BootProfile.cpp
+ *
+ * Boot phase time stamps.
+ */
+
+#include "BootProfile.h"
+#include "freertos/FreeRTOS.h"
+#include <esp_timer.h>
+#include <cstdio>
+#include <logdef.h>
+
+BootProfile::t_stamp BootProfile::stamps[BOOT_MAX_PHASES];
+int BootProfile::num = 0;
+
+static portMUX_TYPE bootMux = portMUX_INITIALIZER_UNLOCKED;
+
+void BootProfile::mark( const char *phase ){
+	int64_t now = esp_timer_get_time();
+	portENTER_CRITICAL( &bootMux );  // phases may end in different tasks
+	if( num < BOOT_MAX_PHASES ){
+		stamps[num].phase = phase;
+		stamps[num].us = now;
+		num++;
+	}
+	portEXIT_CRITICAL( &bootMux );
+}
+
+void BootProfile::log(){
+	int64_t prev = 0;
+	for( int i=0; i<num; i++ ){
+		ESP_LOGI(FNAME,"Boot %-10s at %5d ms (+%d ms)", stamps[i].phase, (int)(stamps[i].us/1000), (int)((stamps[i].us-prev)/1000) );
+		prev = stamps[i].us;
+	}
+}
+
+int BootProfile::json( char *str, size_t len ){
+	size_t pos = 0;
+	int n = snprintf( str, len, "{" );
+	for( int i=0; i<num && n >= 0 && pos+n < len; i++ ){
+		pos += n;
+		n = snprintf( str+pos, len-pos, "%s\"%s\":%d", i ? "," : "", stamps[i].phase, (int)(stamps[i].us/1000) );
+	}
+	if( n < 0 || pos+n >= len )
+		return -1;
+	pos += n;
+	n = snprintf( str+pos, len-pos, "}" );
+	if( n < 0 || pos+n >= len )
+		return -1;
+	return pos+n;
+}
@@ -0,0 +1,31 @@
+/*
+ * BootProfile.h
+ *
+ * Records a time stamp per boot phase (us since power on via esp_timer),
+ * for the log and for /status.json.
+ *
+ *   BootProfile::mark( "setup" );   // end of phase "setup"
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#define BOOT_MAX_PHASES 16
+
+class BootProfile {
+public:
+	static void mark( const char *phase );        // phase must be a string literal
+	static void log();
+	static int  json( char *str, size_t len );   // {"phase":ms,...}, returns length or -1 if too small
+	static inline int64_t elapsed() { return num ? stamps[num-1].us : 0; }
+
+private:
+	typedef struct {
+		const char *phase;
+		int64_t    us;
+	} t_stamp;
+	static t_stamp stamps[BOOT_MAX_PHASES];
+	static int num;
+};
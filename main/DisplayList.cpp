@@ -0,0 +1,209 @@
+#include "DisplayList.h"
+#include <string.h>
+
+#define CULLED   0xff   // state[] of a culled draw
+#define UNIQUE   0xfe   // state table full, never a duplicate
+
+static inline coordinate_t min16( int a, int b ) { return a < b ? a : b; }
+static inline coordinate_t max16( int a, int b ) { return a > b ? a : b; }
+
+bool DisplayList::add( const t_dl_cmd &c, const char *t, size_t len ){
+	if( ncmd == DISPLAY_LIST_CMDS )
+		return false;
+	cmd[ncmd] = c;
+	if( c.op == DL_TEXT ){
+		if( ntext + len + 1 > DISPLAY_LIST_TEXT )
+			return false;
+		memcpy( text + ntext, t, len );
+		text[ntext + len] = 0;
+		cmd[ncmd].a[2] = ntext;
+		cmd[ncmd].a[3] = len;
+		ntext += len + 1;
+	}
+	state[ncmd++] = 0;
+	return true;
+}
+
+// Area a draw may paint, within the clip of the given state. Conservative for
+// everything but boxes, those paint exactly their area (see eglib_DrawBox()).
+// False if the draw paints nothing.
+bool DisplayList::bounds( const t_dl_cmd &c, const eglib_t *s, t_rect &r ){
+	const int16_t *a = c.a;
+	switch( c.op ){
+	case DL_CLEAR:
+	case DL_BOX: {
+		int x = 0, y = 0, w = eglib_GetWidth( (eglib_t *)s ), h = eglib_GetHeight( (eglib_t *)s );
+		if( c.op == DL_BOX ){
+			x = a[0]; y = a[1]; w = a[2]; h = a[3];
+		}
+		if( w <= 0 || h <= 0 )
+			return false;
+		r.x0 = max16( x, s->drawing.clip_xmin );
+		r.x1 = min16( x + w, s->drawing.clip_xmax ) - 1;
+		r.y0 = max16( y, s->drawing.clip_ymin );
+		r.y1 = min16( y + h - 1, s->drawing.clip_ymax );
+		return r.x0 <= r.x1 && r.y0 <= r.y1;
+	}
+	case DL_FRAME: case DL_RBOX: case DL_RFRAME:
+		r = { a[0], a[1], (coordinate_t)(a[0] + a[2]), (coordinate_t)(a[1] + a[3]) };
+		break;
+	case DL_LINE:
+		r = { min16( a[0], a[2] ), min16( a[1], a[3] ), max16( a[0], a[2] ), max16( a[1], a[3] ) };
+		break;
+	case DL_PIXEL:
+		r = { a[0], a[1], a[0], a[1] };
+		break;
+	case DL_TRIANGLE: case DL_TETRAGON: {
+		int n = c.op == DL_TRIANGLE ? 3 : 4;
+		r = { a[0], a[1], a[0], a[1] };
+		for( int i=1; i<n; i++ ){
+			r.x0 = min16( r.x0, a[2*i] ); r.x1 = max16( r.x1, a[2*i] );
+			r.y0 = min16( r.y0, a[2*i+1] ); r.y1 = max16( r.y1, a[2*i+1] );
+		}
+		break;
+	}
+	case DL_CIRCLE: case DL_DISC:
+		r = { (coordinate_t)(a[0] - a[2]), (coordinate_t)(a[1] - a[2]), (coordinate_t)(a[0] + a[2]), (coordinate_t)(a[1] + a[2]) };
+		break;
+	default:  // text: anywhere in the clip
+		r = { s->drawing.clip_xmin, s->drawing.clip_ymin, s->drawing.clip_xmax, s->drawing.clip_ymax };
+		break;
+	}
+	// a pixel of slack for rounding in the rasterisers
+	r.x0 = max16( r.x0 - 1, s->drawing.clip_xmin );
+	r.y0 = max16( r.y0 - 1, s->drawing.clip_ymin );
+	r.x1 = min16( r.x1 + 1, s->drawing.clip_xmax );
+	r.y1 = min16( r.y1 + 1, s->drawing.clip_ymax );
+	return r.x0 <= r.x1 && r.y0 <= r.y1;
+}
+
+bool DisplayList::same( const t_dl_cmd &a, const t_dl_cmd &b ){
+	if( a.op != b.op || a.opt != b.opt )
+		return false;
+	if( a.op == DL_TEXT )
+		return a.a[0] == b.a[0] && a.a[1] == b.a[1] && !strcmp( text + a.a[2], text + b.a[2] );
+	return !memcmp( a.a, b.a, sizeof(a.a) );
+}
+
+void DisplayList::cull( eglib_t *eglib ){
+	typedef struct {
+		color_t color[2];
+		const struct font_t *font;
+		bool filled;
+		e_font_origin origin;
+		coordinate_t clip[4];
+	} t_state;
+	static t_rect area[DISPLAY_LIST_CMDS];   // only the display task culls
+	t_state states[DISPLAY_LIST_STATES];
+	uint8_t nstates = 0;
+	eglib_t s = *eglib;  // drawing state only, nothing is drawn on the copy
+
+	// forward: what each draw paints and with which state
+	nculled = 0;
+	for( int i=0; i<ncmd; i++ ){
+		const t_dl_cmd &c = cmd[i];
+		switch( c.op ){
+		case DL_COLOR:
+			eglib_SetIndexColor( &s, c.opt, c.color.r, c.color.g, c.color.b );
+			continue;
+		case DL_FONT:
+			eglib_setFilledMode( &s, c.opt );
+			eglib_SetFont( &s, c.font );
+			continue;
+		case DL_FONT_ORIGIN:
+			eglib_setFontOrigin( &s, (e_font_origin)c.opt );
+			continue;
+		case DL_CLIP:
+			eglib_setClipRange( &s, c.a[0], c.a[1], c.a[2], c.a[3] );
+			continue;
+		case DL_UNCLIP:
+			eglib_undoClipRange( &s );
+			continue;
+		case DL_SCROLL: case DL_SCROLL_MARGINS:
+			continue;
+		}
+		if( !bounds( c, &s, area[i] ) ){
+			state[i] = CULLED;   // all clipped away
+			nculled++;
+			continue;
+		}
+		t_state st;
+		memset( &st, 0, sizeof(st) );
+		st.color[0] = s.drawing.color_index[0];
+		st.color[1] = s.drawing.color_index[1];
+		st.font = s.drawing.font;
+		st.filled = s.drawing.filled_mode;
+		st.origin = s.drawing.font_origin;
+		st.clip[0] = s.drawing.clip_xmin; st.clip[1] = s.drawing.clip_ymin;
+		st.clip[2] = s.drawing.clip_xmax; st.clip[3] = s.drawing.clip_ymax;
+		uint8_t id = 0;
+		while( id < nstates && memcmp( &states[id], &st, sizeof(st) ) )
+			id++;
+		if( id == nstates ){
+			if( nstates < DISPLAY_LIST_STATES )
+				states[nstates++] = st;
+			else
+				id = UNIQUE;
+		}
+		state[i] = id;
+	}
+
+	// backward: drop draws a later box paints over or a later identical draw repeats
+	t_rect occluder[DISPLAY_LIST_OCCLUDERS];
+	int noccluders = 0;
+	for( int i=ncmd-1; i>=0; i-- ){
+		const t_dl_cmd &c = cmd[i];
+		if( c.op == DL_SCROLL || c.op == DL_SCROLL_MARGINS ){
+			noccluders = 0;
+			continue;
+		}
+		if( c.op < DL_CLEAR || state[i] == CULLED )
+			continue;
+		const t_rect &r = area[i];
+		bool covered = false;
+		for( int k=0; k<noccluders && !covered; k++ )
+			covered = r.x0 >= occluder[k].x0 && r.x1 <= occluder[k].x1 && r.y0 >= occluder[k].y0 && r.y1 <= occluder[k].y1;
+		for( int j=i+1; j<ncmd && !covered && state[i] != UNIQUE; j++ ){
+			if( cmd[j].op == DL_SCROLL || cmd[j].op == DL_SCROLL_MARGINS )
+				break;
+			covered = cmd[j].op >= DL_CLEAR && state[j] == state[i] && same( c, cmd[j] );
+		}
+		if( covered ){
+			state[i] = CULLED;
+			nculled++;
+		}
+		else if( (c.op == DL_BOX || c.op == DL_CLEAR) && noccluders < DISPLAY_LIST_OCCLUDERS )
+			occluder[noccluders++] = r;
+	}
+}
+
+void DisplayList::run( eglib_t *eglib ){
+	for( int i=0; i<ncmd; i++ ){
+		const t_dl_cmd &c = cmd[i];
+		const int16_t *a = c.a;
+		if( c.op >= DL_CLEAR && state[i] == CULLED )
+			continue;
+		switch( c.op ){
+		case DL_COLOR:         eglib_SetIndexColor( eglib, c.opt, c.color.r, c.color.g, c.color.b ); break;
+		case DL_FONT:          eglib_setFilledMode( eglib, c.opt ); eglib_SetFont( eglib, c.font ); break;
+		case DL_FONT_ORIGIN:   eglib_setFontOrigin( eglib, (e_font_origin)c.opt ); break;
+		case DL_CLIP:          eglib_setClipRange( eglib, a[0], a[1], a[2], a[3] ); break;
+		case DL_UNCLIP:        eglib_undoClipRange( eglib ); break;
+		case DL_SCROLL:        eglib_scrollScreen( eglib, a[0] ); break;
+		case DL_SCROLL_MARGINS: eglib_setScrollMargins( eglib, a[0], a[1] ); break;
+		case DL_CLEAR:         eglib_ClearScreen( eglib ); break;
+		case DL_BOX:           eglib_DrawBox( eglib, a[0], a[1], a[2], a[3] ); break;
+		case DL_FRAME:         eglib_DrawFrame( eglib, a[0], a[1], a[2], a[3] ); break;
+		case DL_RBOX:          eglib_DrawRoundBox( eglib, a[0], a[1], a[2], a[3], a[4] ); break;
+		case DL_RFRAME:        eglib_DrawRoundFrame( eglib, a[0], a[1], a[2], a[3], a[4] ); break;
+		case DL_LINE:          eglib_DrawLine( eglib, a[0], a[1], a[2], a[3] ); break;
+		case DL_PIXEL:         eglib_DrawPixel( eglib, a[0], a[1] ); break;
+		case DL_TRIANGLE:      eglib_DrawFilledTriangle( eglib, a[0], a[1], a[2], a[3], a[4], a[5] ); break;
+		case DL_TETRAGON:      eglib_DrawTetragon( eglib, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7] ); break;
+		case DL_CIRCLE:        eglib_DrawCircle( eglib, a[0], a[1], a[2], c.opt ); break;
+		case DL_DISC:          eglib_DrawDisc( eglib, a[0], a[1], a[2], c.opt ); break;
+		case DL_TEXT:          eglib_DrawText( eglib, a[0], a[1], text + a[2] ); break;
+		case DL_WCHAR:         eglib_DrawWChar( eglib, a[0], a[1], (wchar_t)(uint16_t)a[2] ); break;
+		}
+	}
+}
@@ -0,0 +1,72 @@
+/*
+ * DisplayList.h
+ *
+ * Retained drawing commands for AdaptUGC: drawing calls are recorded into a
+ * fixed arena and executed later on the display's eglib in one batch.
+ * Before execution, draws that a later command repaints anyway are culled:
+ * identical draws with the same colors, font and clip, and shapes covered
+ * by a later box or clear screen.
+ *
+ *   list.add( cmd );                  // false when the arena is full
+ *   list.cull( eglib );
+ *   list.run( eglib );
+ *   list.clear();
+ */
+
+#pragma once
+
+extern "C" {
+#include "eglib.h"
+#include "eglib/display.h"
+}
+#include <cstddef>
+#include <cstdint>
+
+#define DISPLAY_LIST_CMDS       256   // commands per list, 20 bytes each
+#define DISPLAY_LIST_TEXT       1024  // bytes of printed text per list
+#define DISPLAY_LIST_OCCLUDERS  16    // boxes checked for overdraw
+#define DISPLAY_LIST_STATES     16    // distinct drawing states told apart for duplicates
+
+typedef enum {
+	// drawing state, never culled
+	DL_COLOR, DL_FONT, DL_FONT_ORIGIN, DL_CLIP, DL_UNCLIP,
+	// moves display content, nothing is culled across it
+	DL_SCROLL, DL_SCROLL_MARGINS,
+	// drawing
+	DL_CLEAR, DL_BOX, DL_FRAME, DL_RBOX, DL_RFRAME, DL_LINE, DL_PIXEL,
+	DL_TRIANGLE, DL_TETRAGON, DL_CIRCLE, DL_DISC, DL_TEXT, DL_WCHAR
+} e_dl_op;
+
+typedef struct {
+	uint8_t op;
+	uint8_t opt;               // color index, filled font, font origin, circle options
+	union {
+		int16_t a[8];          // coordinates, DL_TEXT: x, y, text offset, length
+		const struct font_t *font;
+		struct { uint8_t r, g, b; } color;
+	};
+} t_dl_cmd;
+
+class DisplayList {
+public:
+	DisplayList() { clear(); }
+	bool add( const t_dl_cmd &cmd, const char *text=nullptr, size_t len=0 );
+	void cull( eglib_t *eglib );     // eglib: state the list starts from, left untouched
+	void run( eglib_t *eglib );
+	inline void clear() { ncmd = 0; ntext = 0; }
+	inline bool empty() const { return ncmd == 0; }
+	inline uint16_t size() const { return ncmd; }
+	inline uint16_t culled() const { return nculled; }
+
+private:
+	typedef struct { coordinate_t x0, y0, x1, y1; } t_rect;
+	bool bounds( const t_dl_cmd &c, const eglib_t *state, t_rect &r );
+	bool same( const t_dl_cmd &a, const t_dl_cmd &b );
+
+	t_dl_cmd cmd[DISPLAY_LIST_CMDS];
+	uint8_t state[DISPLAY_LIST_CMDS];  // drawing state of each draw, 0xff: culled
+	char text[DISPLAY_LIST_TEXT];
+	uint16_t ncmd;
+	uint16_t ntext;
+	uint16_t nculled = 0;
+};
@@ -3,6 +3,7 @@
 #include "Colors.h"
 #include "math.h"
 #include "pflaa2.h"
+#include "Traffic.h"
 #include <iostream>
 #include <sstream>
 
@@ -188,8 +189,9 @@ void Flarm::parsePFLAA( const char *pflaa ){
 		PFLAA.climbRate = std::stof(token);
 	std::getline(ss, token, ',');
 	if( !token.empty() )
-		sscanf(token.c_str(), "%s", PFLAA.acftType);
+		sscanf(token.c_str(), "%2[0-9A-Fa-f]", PFLAA.acftType);  // token still holds "*<cs>"
 
+	Traffic::update( PFLAA );
 	_tick=0;
 	timeout = FLARM_TIMEOUT;
 	if( PFLAA.groundSpeed > 3.6 ){  // only regard moving objects
@@ -244,6 +246,7 @@ void Flarm::flarmSim(){
 }
 
 void Flarm::progress(){  //  per second
+	Traffic::tick();
 	if( timeout ){
 		timeout--;
 	}
@@ -490,7 +493,8 @@ void Flarm::parsePFLAX( const char *msg, int port ) {
 
 void Flarm::drawDownloadInfo() {
 	// ESP_LOGI(FNAME,"---> Flarm::drawDownloadInfo is called"  );
-	xSemaphoreTake(spiMutex, portMAX_DELAY );
+	if( !ucg->retained() )
+		xSemaphoreTake(spiMutex, portMAX_DELAY );
 	ucg->setColor( COLOR_WHITE );
 	ucg->setFont(ucg_font_fub20_hr);
 	ucg->setPrintPos(60, 140);
@@ -502,7 +506,10 @@ void Flarm::drawDownloadInfo() {
 	ucg->setFont(ucg_font_fub11_hr);
 	ucg->setPrintPos(20, 280);
 	ucg->printf(PROGMEM"(restarts on end download)");
-	xSemaphoreGive(spiMutex);
+	if( ucg->retained() )
+		ucg->commit();   // the display task owns the bus
+	else
+		xSemaphoreGive(spiMutex);
 }
 
 
@@ -609,7 +616,8 @@ void Flarm::drawFlarmWarning(){
 	_tick++;
 	if( _tick > 500 ) // age FLARM alarm in case there is no more input  50 per second = 10 sec
 		AlarmLevel = 0;
-	xSemaphoreTake(spiMutex,portMAX_DELAY );
+	if( !ucg->retained() )
+		xSemaphoreTake(spiMutex,portMAX_DELAY );
 
 	if( AlarmLevel == 3 ) { // highest, impact 0-8 seconds
 		alarm = AUDIO_ALARM_FLARM_3;
@@ -685,5 +693,8 @@ void Flarm::drawFlarmWarning(){
 		oldBear = RelativeBearing;
 	}
 
-	xSemaphoreGive(spiMutex);
+	if( ucg->retained() )
+		ucg->commit();
+	else
+		xSemaphoreGive(spiMutex);
 }
@@ -78,6 +78,7 @@ public:
 			}
 	}
 	static inline bool gpsStatus() { return myGPS_OK; }
+	static inline int traffic() { return RX; }  // devices received, from PFLAU
 
 	static inline bool objectInRange( float dist ){
 		if ( closest_object < dist )
@@ -97,11 +98,12 @@ public:
 	}
 	static void begin();
 	static void taskFlarm(void *pvParameters);
-	static void startSim() { flarm_sim = true; };
+	static void startSim() { sim_tick = 0; flarm_sim = true; };
 	static inline bool getSim() { return flarm_sim; };
 
-private:
 	static int calcNMEACheckSum(const char *nmea);
+
+private:
 	static int getNMEACheckSum(const char *nmea);
 	static void drawClearTriangle( int x, int y, int rb, int dist, int size, int factor );
 	static void drawClearVerticalTriangle( int x, int y, int rb, int dist, int size, int factor );
@@ -0,0 +1,137 @@
+/*
+ * Gzip.cpp
+ *
+ * Fixed Huffman deflate (RFC 1951 3.2.6) in a gzip frame (RFC 1952).
+ */
+
+#include "Gzip.h"
+#include <cstdlib>
+#include <cstring>
+#include <esp_rom_crc.h>
+
+static const uint16_t lenBase[29] = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258 };
+static const uint8_t  lenExtra[29] = { 0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0 };
+static const uint16_t distBase[30] = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577 };
+static const uint8_t  distExtra[30] = { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13 };
+
+static inline int hash3( const uint8_t *p ){
+	return ((p[0] << 6) ^ (p[1] << 3) ^ p[2]) & ((1 << GZIP_HASH_BITS) - 1);
+}
+
+Gzip::Gzip() : head(nullptr), out(nullptr), bitbuf(0), bitcnt(0), crc(0), size(0), started(false) {}
+
+Gzip::~Gzip(){
+	free( head );
+}
+
+bool Gzip::begin(){
+	if( !head )
+		head = (uint16_t *)malloc( sizeof(uint16_t) << GZIP_HASH_BITS );
+	bitbuf = 0;
+	bitcnt = 0;
+	crc = 0;
+	size = 0;
+	started = false;
+	return head != nullptr;
+}
+
+void Gzip::put( uint32_t val, int n ){
+	bitbuf |= val << bitcnt;
+	bitcnt += n;
+	while( bitcnt >= 8 ){
+		*out++ = bitbuf & 0xff;
+		bitbuf >>= 8;
+		bitcnt -= 8;
+	}
+}
+
+void Gzip::putCode( uint32_t code, int n ){
+	uint32_t rev = 0;
+	for( int i=0; i<n; i++ ){
+		rev = (rev << 1) | (code & 1);
+		code >>= 1;
+	}
+	put( rev, n );
+}
+
+// literal/length alphabet, fixed code lengths 8/9/7/8
+void Gzip::symbol( int sym ){
+	if( sym < 144 )
+		putCode( 0x30 + sym, 8 );
+	else if( sym < 256 )
+		putCode( 0x190 + sym - 144, 9 );
+	else if( sym < 280 )
+		putCode( sym - 256, 7 );
+	else
+		putCode( 0xc0 + sym - 280, 8 );
+}
+
+void Gzip::match( int len, int dist ){
+	int l = 28;
+	while( lenBase[l] > len )
+		l--;
+	symbol( 257 + l );
+	put( len - lenBase[l], lenExtra[l] );
+	int d = 29;
+	while( distBase[d] > dist )
+		d--;
+	putCode( d, 5 );
+	put( dist - distBase[d], distExtra[d] );
+}
+
+void Gzip::header(){
+	static const uint8_t gzipHeader[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff };
+	if( started )
+		return;
+	memcpy( out, gzipHeader, sizeof(gzipHeader) );
+	out += sizeof(gzipHeader);
+	started = true;
+}
+
+size_t Gzip::compress( const uint8_t *in, size_t len, uint8_t *buf ){
+	out = buf;
+	header();
+	crc = esp_rom_crc32_le( crc, in, len );
+	size += len;
+
+	memset( head, 0, sizeof(uint16_t) << GZIP_HASH_BITS );
+	put( 0, 1 );   // not the final block
+	put( 1, 2 );   // fixed Huffman codes
+	size_t i = 0;
+	while( i < len ){
+		if( i+3 <= len ){
+			int h = hash3( in+i );
+			int cand = (int)head[h] - 1;
+			head[h] = i + 1;
+			if( cand >= 0 && !memcmp( in+cand, in+i, 3 ) ){
+				size_t max = (len - i < 258) ? len - i : 258;
+				size_t m = 3;
+				while( m < max && in[cand+m] == in[i+m] )
+					m++;
+				match( m, i - cand );
+				for( size_t k=1; k<m && i+k+3 <= len; k++ )
+					head[hash3( in+i+k )] = i + k + 1;
+				i += m;
+				continue;
+			}
+		}
+		symbol( in[i++] );
+	}
+	symbol( 256 );   // end of block, the partial byte stays in bitbuf
+	return out - buf;
+}
+
+size_t Gzip::finish( uint8_t *buf ){
+	out = buf;
+	header();      // empty stream
+	put( 1, 1 );   // final, empty block
+	put( 1, 2 );
+	symbol( 256 );
+	if( bitcnt )
+		put( 0, 8 - bitcnt );
+	for( int i=0; i<4; i++ )
+		*out++ = crc >> (8*i);
+	for( int i=0; i<4; i++ )
+		*out++ = size >> (8*i);
+	return out - buf;
+}
@@ -0,0 +1,48 @@
+/*
+ * Gzip.h
+ *
+ * Small streaming gzip encoder for HTTP responses (Content-Encoding: gzip).
+ * Each compress() call emits one deflate block with the fixed Huffman code,
+ * matches are searched inside that input only, so it needs no window memory
+ * besides a 2 KB hash table. Good enough for base64 text and zero filled
+ * dumps, not meant to compete with zlib.
+ *
+ *   Gzip gz;
+ *   gz.begin();
+ *   n = gz.compress( in, len, out );    // out has Gzip::bound( len ) bytes
+ *   n = gz.finish( out );               // out has GZIP_TRAILER_MAX bytes
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#define GZIP_HASH_BITS    10
+#define GZIP_MAX_INPUT    65534   // per compress() call, positions are 16 bit
+#define GZIP_TRAILER_MAX  32
+
+class Gzip {
+public:
+	Gzip();
+	~Gzip();
+	bool begin();                                              // false if out of memory
+	size_t compress( const uint8_t *in, size_t len, uint8_t *out );
+	size_t finish( uint8_t *out );
+	static inline size_t bound( size_t len ) { return len + len/8 + 24; }
+
+private:
+	void put( uint32_t val, int n );
+	void putCode( uint32_t code, int n );   // Huffman code, MSB first
+	void symbol( int sym );
+	void match( int len, int dist );
+	void header();                          // once, before the first block
+
+	uint16_t *head;       // last position + 1 per hash, 0 if none
+	uint8_t  *out;
+	uint32_t bitbuf;
+	int      bitcnt;
+	uint32_t crc;
+	uint32_t size;
+	bool     started;
+};
@@ -0,0 +1,218 @@
+/*
+ * OtaDecoder.cpp
+ *
+ * Plain, zlib packed and delta OTA images, streaming inflate via ROM miniz.
+ */
+
+#include "OtaDecoder.h"
+#include "OtaDelta.h"
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <esp_image_format.h>
+#include <esp_ota_ops.h>
+#include <esp32/rom/miniz.h>
+#include <mbedtls/sha256.h>
+#include <logdef.h>
+
+OtaDecoder::sink_t OtaDecoder::sink = nullptr;
+int OtaDecoder::format = -1;
+t_ota_header OtaDecoder::hdr;
+t_ota_delta OtaDecoder::delta;
+size_t OtaDecoder::hdrLen = 0;
+size_t OtaDecoder::_size = 0;
+size_t OtaDecoder::decoded = 0;
+bool OtaDecoder::inflated = false;
+bool OtaDecoder::zlibStarted = false;
+void *OtaDecoder::inflator = nullptr;
+uint8_t *OtaDecoder::window = nullptr;
+size_t OtaDecoder::windowPos = 0;
+void *OtaDecoder::sha = nullptr;
+
+static inline uint32_t get_le32( const uint8_t *p ){
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void OtaDecoder::begin( sink_t s ){
+	release();
+	sink = s;
+	format = -1;
+	hdrLen = 0;
+	_size = 0;
+	decoded = 0;
+	inflated = false;
+	zlibStarted = false;
+	windowPos = 0;
+}
+
+void OtaDecoder::release(){
+	free( inflator );
+	inflator = nullptr;
+	free( window );
+	window = nullptr;
+	if( sha ){
+		mbedtls_sha256_free( (mbedtls_sha256_context*)sha );
+		free( sha );
+		sha = nullptr;
+	}
+}
+
+// collects and checks the header of a packed image, used is what was taken from data
+esp_err_t OtaDecoder::header( const uint8_t *data, size_t len, size_t &used ){
+	size_t need = sizeof(hdr);
+	if( hdrLen >= sizeof(hdr) && hdr.format == OTA_FORMAT_DELTA )
+		need += sizeof(delta);
+	used = std::min( len, need - hdrLen );
+	uint8_t *h = (hdrLen < sizeof(hdr)) ? (uint8_t*)&hdr + hdrLen : (uint8_t*)&delta + hdrLen - sizeof(hdr);
+	memcpy( h, data, used );
+	hdrLen += used;
+	if( memcmp( hdr.magic, OTA_PACK_MAGIC, std::min( hdrLen, sizeof(hdr.magic) ) ) )
+		return ESP_ERR_OTA_VALIDATE_FAILED;
+	if( hdrLen < sizeof(hdr) )
+		return ESP_OK;
+	if( hdr.format != OTA_FORMAT_ZLIB && hdr.format != OTA_FORMAT_DELTA ){
+		ESP_LOGE(FNAME,"Unknown OTA format %d", hdr.format );
+		return ESP_ERR_NOT_SUPPORTED;
+	}
+	if( hdr.format == OTA_FORMAT_DELTA && hdrLen < sizeof(hdr) + sizeof(delta) ){
+		if( used < len ){  // the delta part is in data as well
+			size_t more;
+			esp_err_t err = header( data + used, len - used, more );
+			used += more;
+			return err;
+		}
+		return ESP_OK;
+	}
+	_size = get_le32( (uint8_t*)&hdr + offsetof(t_ota_header, size) );
+	if( hdr.format == OTA_FORMAT_DELTA ){
+		const uint8_t *running = runningSha256();
+		if( !running || memcmp( running, delta.source_sha256, sizeof(delta.source_sha256) ) ){
+			ESP_LOGE(FNAME,"Delta update made for another image than the running one");
+			return ESP_ERR_INVALID_VERSION;
+		}
+		OtaDelta::begin( deltaOut, deltaSource, esp_ota_get_running_partition()->size );
+	}
+	inflator = malloc( sizeof(tinfl_decompressor) );
+	window = (uint8_t*)malloc( 1 << OTA_INFLATE_WINDOW_BITS );
+	sha = malloc( sizeof(mbedtls_sha256_context) );
+	if( !inflator || !window || !sha ){
+		release();
+		return ESP_ERR_NO_MEM;
+	}
+	tinfl_init( (tinfl_decompressor*)inflator );
+	mbedtls_sha256_init( (mbedtls_sha256_context*)sha );
+	mbedtls_sha256_starts_ret( (mbedtls_sha256_context*)sha, 0 );
+	format = hdr.format;
+	ESP_LOGI(FNAME,"Packed OTA image, format %d, size %d", format, _size );
+	return ESP_OK;
+}
+
+// SHA-256 of the running app image, identifies the source of a delta update
+const uint8_t *OtaDecoder::runningSha256(){
+	static uint8_t running[32];
+	static bool valid = false;
+	if( !valid )
+		valid = esp_partition_get_sha256( esp_ota_get_running_partition(), running ) == ESP_OK;
+	return valid ? running : nullptr;
+}
+
+int OtaDecoder::deltaOut( const uint8_t *data, size_t len ){
+	return output( data, len );
+}
+
+int OtaDecoder::deltaSource( size_t offset, uint8_t *data, size_t len ){
+	return esp_partition_read( esp_ota_get_running_partition(), offset, data, len );
+}
+
+// decoded image data, hashed and passed on to the sink
+esp_err_t OtaDecoder::output( const uint8_t *data, size_t len ){
+	if( decoded + len > _size ){
+		ESP_LOGE(FNAME,"Decoded image exceeds size %d", _size );
+		return ESP_ERR_INVALID_SIZE;
+	}
+	decoded += len;
+	mbedtls_sha256_update_ret( (mbedtls_sha256_context*)sha, data, len );
+	return (*sink)( data, len );
+}
+
+esp_err_t OtaDecoder::inflate( const uint8_t *data, size_t len ){
+	if( !zlibStarted && len ){
+		// zlib CMF: deflate and log2 of the window size - 8
+		int bits = (data[0] >> 4) + 8;
+		if( (data[0] & 0x0f) != 8 || bits > OTA_INFLATE_WINDOW_BITS ){
+			ESP_LOGE(FNAME,"Unsupported zlib stream, window 2^%d bytes, max. 2^%d", bits, OTA_INFLATE_WINDOW_BITS );
+			return ESP_ERR_NOT_SUPPORTED;
+		}
+		zlibStarted = true;
+	}
+	const size_t wsize = 1 << OTA_INFLATE_WINDOW_BITS;
+	while( !inflated ){
+		size_t in = len;
+		size_t out = wsize - windowPos;
+		tinfl_status status = tinfl_decompress( (tinfl_decompressor*)inflator, data, &in, window, window + windowPos, &out,
+				TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_COMPUTE_ADLER32 | TINFL_FLAG_HAS_MORE_INPUT );
+		data += in;
+		len -= in;
+		if( out ){
+			esp_err_t err;
+			if( format == OTA_FORMAT_DELTA )
+				err = OtaDelta::feed( window + windowPos, out );
+			else
+				err = output( window + windowPos, out );
+			if( err < 0 ){  // OtaDelta error
+				ESP_LOGE(FNAME,"Delta patch invalid, error %d", err );
+				return ESP_ERR_INVALID_ARG;
+			}
+			if( err != ESP_OK )
+				return err;
+			windowPos = (windowPos + out) & (wsize - 1);
+		}
+		if( status < TINFL_STATUS_DONE ){
+			ESP_LOGE(FNAME,"Inflate failed, status %d", status );
+			return ESP_ERR_INVALID_CRC;
+		}
+		if( status == TINFL_STATUS_DONE )
+			inflated = true;
+		else if( status == TINFL_STATUS_NEEDS_MORE_INPUT )
+			break;
+		// else TINFL_STATUS_HAS_MORE_OUTPUT: window full, continue
+	}
+	return ESP_OK;
+}
+
+esp_err_t OtaDecoder::feed( const uint8_t *data, size_t len ){
+	if( format < 0 && hdrLen == 0 && len && data[0] == ESP_IMAGE_HEADER_MAGIC )
+		format = OTA_FORMAT_PLAIN;
+	if( format < 0 ){
+		size_t used;
+		esp_err_t err = header( data, len, used );
+		if( err != ESP_OK )
+			return err;
+		data += used;
+		len -= used;
+	}
+	switch( format ){
+	case OTA_FORMAT_PLAIN:
+		return (*sink)( data, len );
+	case OTA_FORMAT_ZLIB:
+	case OTA_FORMAT_DELTA:
+		return inflate( data, len );
+	}
+	return ESP_OK;  // header not complete yet
+}
+
+esp_err_t OtaDecoder::finish(){
+	if( format == OTA_FORMAT_PLAIN )
+		return ESP_OK;
+	if( format < 0 || !inflated || decoded != _size || (format == OTA_FORMAT_DELTA && !OtaDelta::complete()) ){
+		ESP_LOGE(FNAME,"Packed image incomplete, %d of %d bytes", decoded, _size );
+		return ESP_ERR_INVALID_SIZE;
+	}
+	uint8_t digest[32];
+	mbedtls_sha256_finish_ret( (mbedtls_sha256_context*)sha, digest );
+	if( memcmp( digest, hdr.sha256, sizeof(digest) ) ){
+		ESP_LOGE(FNAME,"Decoded image SHA-256 mismatch");
+		return ESP_ERR_INVALID_CRC;
+	}
+	return ESP_OK;
+}
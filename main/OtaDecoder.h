@@ -0,0 +1,75 @@
+/*
+ * OtaDecoder.h
+ *
+ * Decodes the uploaded OTA stream into the app image. A plain app image
+ * (starts with ESP_IMAGE_HEADER_MAGIC) is passed through, a packed image
+ * starts with t_ota_header and carries a zlib stream, see
+ * tools/ota_pack.py. It is inflated in a streaming fashion into a
+ * wrapping window of 1<<OTA_INFLATE_WINDOW_BITS bytes, so the host has to
+ * compress with a window not bigger than that. The decoded image is
+ * checked against size and SHA-256 from the header.
+ *
+ * A delta update carries a zlib compressed OtaDelta patch against the
+ * running image instead, see tools/ota_delta.py.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <esp_err.h>
+
+#define OTA_PACK_MAGIC           "XCU1"
+#define OTA_INFLATE_WINDOW_BITS  13     // 8 KB window
+
+typedef enum {
+	OTA_FORMAT_PLAIN = 0,               // raw app image
+	OTA_FORMAT_ZLIB  = 1,               // zlib compressed app image
+	OTA_FORMAT_DELTA = 2                // zlib compressed patch, t_ota_delta follows the header
+} ota_format_t;
+
+// all numbers little endian
+typedef struct {
+	char     magic[4];                  // OTA_PACK_MAGIC
+	uint8_t  format;                    // ota_format_t
+	uint8_t  reserved[3];
+	uint32_t size;                      // decoded image size
+	uint8_t  sha256[32];                // of the decoded image
+} t_ota_header;
+
+typedef struct {
+	uint8_t  source_sha256[32];         // running image the patch is made for
+} t_ota_delta;
+
+class OtaDecoder {
+public:
+	typedef esp_err_t (*sink_t)( const uint8_t *data, size_t len );
+
+	static void begin( sink_t sink );
+	static esp_err_t feed( const uint8_t *data, size_t len );   // upload data, in sequence
+	static esp_err_t finish();                                  // checks the decoded image is complete
+	static void release();
+	static inline size_t imageSize() { return _size; }          // 0 if not known (yet)
+	static const uint8_t *runningSha256();                      // as esp_partition_get_sha256(), nullptr on error
+
+private:
+	static esp_err_t header( const uint8_t *data, size_t len, size_t &used );
+	static esp_err_t inflate( const uint8_t *data, size_t len );
+	static esp_err_t output( const uint8_t *data, size_t len );
+	static int deltaOut( const uint8_t *data, size_t len );
+	static int deltaSource( size_t offset, uint8_t *data, size_t len );
+
+	static sink_t sink;
+	static int format;                  // ota_format_t, -1 while not known
+	static t_ota_header hdr;
+	static t_ota_delta delta;
+	static size_t hdrLen;
+	static size_t _size;
+	static size_t decoded;
+	static bool zlibStarted;
+	static bool inflated;               // end of the zlib stream seen
+	static void *inflator;
+	static uint8_t *window;
+	static size_t windowPos;
+	static void *sha;
+};
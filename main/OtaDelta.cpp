@@ -0,0 +1,109 @@
+/*
+ * OtaDelta.cpp
+ *
+ * Streaming patch applier for delta updates.
+ */
+
+#include "OtaDelta.h"
+#include <cstring>
+#include <algorithm>
+
+OtaDelta::sink_t OtaDelta::sink = nullptr;
+OtaDelta::source_t OtaDelta::source = nullptr;
+size_t OtaDelta::sourceSize = 0;
+OtaDelta::state_t OtaDelta::state = OP;
+uint8_t OtaDelta::op = 0;
+uint8_t OtaDelta::args[8];
+size_t OtaDelta::argLen = 0;
+size_t OtaDelta::argNeed = 0;
+uint32_t OtaDelta::srcOff = 0;
+uint32_t OtaDelta::remain = 0;
+uint8_t OtaDelta::buf[OTA_DELTA_BUF];
+
+static inline uint32_t get_le32( const uint8_t *p ){
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void OtaDelta::begin( sink_t snk, source_t src, size_t size ){
+	sink = snk;
+	source = src;
+	sourceSize = size;
+	state = OP;
+}
+
+// 'C', needs no patch data
+int OtaDelta::copy(){
+	while( remain ){
+		size_t n = std::min( (size_t)remain, sizeof(buf) );
+		int err = (*source)( srcOff, buf, n );
+		if( !err )
+			err = (*sink)( buf, n );
+		if( err )
+			return err;
+		srcOff += n;
+		remain -= n;
+	}
+	return 0;
+}
+
+int OtaDelta::feed( const uint8_t *data, size_t len ){
+	int err = 0;
+	while( len && !err ){
+		switch( state ){
+		case OP:
+			op = *data++;
+			len--;
+			if( op != 'C' && op != 'A' && op != 'D' )
+				return ERR_OP;
+			argLen = 0;
+			argNeed = (op == 'D') ? 4 : 8;
+			state = ARGS;
+			break;
+		case ARGS: {
+			size_t n = std::min( len, argNeed - argLen );
+			memcpy( &args[argLen], data, n );
+			argLen += n;
+			data += n;
+			len -= n;
+			if( argLen < argNeed )
+				break;
+			if( op == 'D' ){
+				remain = get_le32( args );
+			}
+			else {
+				srcOff = get_le32( args );
+				remain = get_le32( args+4 );
+				if( srcOff > sourceSize || remain > sourceSize - srcOff )
+					return ERR_RANGE;
+			}
+			state = remain ? DATA : OP;
+			if( op == 'C' ){
+				err = copy();
+				state = OP;
+			}
+			break;
+		}
+		case DATA: {
+			size_t n = std::min( std::min( len, (size_t)remain ), sizeof(buf) );
+			if( op == 'D' ){
+				err = (*sink)( data, n );
+			}
+			else {
+				err = (*source)( srcOff, buf, n );
+				for( size_t i=0; i<n; i++ )
+					buf[i] += data[i];
+				if( !err )
+					err = (*sink)( buf, n );
+				srcOff += n;
+			}
+			data += n;
+			len -= n;
+			remain -= n;
+			if( !remain )
+				state = OP;
+			break;
+		}
+		}
+	}
+	return err;
+}
@@ -0,0 +1,49 @@
+/*
+ * OtaDelta.h
+ *
+ * Rebuilds a new app image from the running one plus a patch, see
+ * tools/ota_delta.py. The patch is a sequence of operations, numbers are
+ * 32 bit little endian:
+ *
+ *   'C' off len           copy len bytes of the source from off
+ *   'A' off len bytes[len] add bytes to the source from off (mod 256)
+ *   'D' len bytes[len]     new data
+ *
+ * Patch data can be fed in pieces of any size. No IDF dependencies, so the
+ * host test in tools/test builds it as well.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#define OTA_DELTA_BUF 256   // source read buffer
+
+class OtaDelta {
+public:
+	typedef int (*sink_t)( const uint8_t *data, size_t len );               // 0 if ok
+	typedef int (*source_t)( size_t offset, uint8_t *data, size_t len );    // 0 if ok
+
+	static void begin( sink_t sink, source_t source, size_t sourceSize );
+	static int feed( const uint8_t *data, size_t len );  // 0 if ok
+	static bool complete() { return state == OP; }      // ends on an operation boundary
+
+	enum { ERR_OP = -1, ERR_RANGE = -2 };
+
+private:
+	enum state_t { OP, ARGS, DATA };
+	static int copy();
+
+	static sink_t sink;
+	static source_t source;
+	static size_t sourceSize;
+	static state_t state;
+	static uint8_t op;
+	static uint8_t args[8];
+	static size_t argLen;
+	static size_t argNeed;
+	static uint32_t srcOff;
+	static uint32_t remain;
+	static uint8_t buf[OTA_DELTA_BUF];
+};
@@ -0,0 +1,169 @@
+/*
+ * OtaWriter.cpp
+ *
+ * Double buffered OTA writer task with erase ahead.
+ */
+
+#include "OtaWriter.h"
+#include "OtaDecoder.h"
+#include "freertos/task.h"
+#include <cstdlib>
+#include <algorithm>
+#include <esp_spi_flash.h>
+#include <esp_image_format.h>
+#include <logdef.h>
+
+// The partition is written directly, not through an esp_ota handle: esp_ota_begin()
+// either erases the whole image size up front or leaves the handle in a mode that
+// refuses esp_ota_write_with_offset(). We erase ourselves ahead of the write cursor
+// and verify the image before it is made the boot partition.
+
+const esp_partition_t *OtaWriter::partition = nullptr;
+char *OtaWriter::buffers = nullptr;
+QueueHandle_t OtaWriter::freeQ = 0;
+QueueHandle_t OtaWriter::fullQ = 0;
+SemaphoreHandle_t OtaWriter::done = 0;
+TaskHandle_t OtaWriter::pid = 0;
+size_t OtaWriter::limit = 0;
+size_t OtaWriter::erased = 0;
+size_t OtaWriter::written = 0;
+size_t OtaWriter::_submitted = 0;
+volatile esp_err_t OtaWriter::_err = ESP_OK;
+
+esp_err_t OtaWriter::begin( size_t upload_size ){
+	if( pid )
+		abort();
+	partition = esp_ota_get_next_update_partition(NULL);
+	if( !partition )
+		return ESP_ERR_NOT_FOUND;
+	if( upload_size > partition->size ){
+		ESP_LOGE(FNAME,"Upload size %d exceeds partition size %d", upload_size, partition->size );
+		return ESP_ERR_INVALID_SIZE;
+	}
+	if( !buffers )
+		buffers = (char*)malloc( OTA_NUM_BUFS * OTA_BUF_SIZE );
+	if( !freeQ ){
+		freeQ = xQueueCreate( OTA_NUM_BUFS, sizeof(char*) );
+		fullQ = xQueueCreate( OTA_NUM_BUFS+1, sizeof(t_ota_chunk) );  // +1 for the stop marker
+		done = xSemaphoreCreateBinary();
+	}
+	if( !buffers || !freeQ || !fullQ || !done )
+		return ESP_ERR_NO_MEM;
+	xQueueReset( freeQ );
+	xQueueReset( fullQ );
+	for( int i=0; i<OTA_NUM_BUFS; i++ ){
+		char *b = &buffers[i*OTA_BUF_SIZE];
+		xQueueSend( freeQ, &b, 0 );
+	}
+	// a plain image is as big as the upload, a packed one tells its size in the header
+	limit = upload_size ? upload_size : partition->size;
+	erased = 0;
+	written = 0;
+	OtaDecoder::begin( write );
+	_submitted = 0;
+	_err = ESP_OK;
+	xTaskCreatePinnedToCore(&writerTask, "otaWriter", 4096, NULL, 5, &pid, 0);
+	ESP_LOGI(FNAME,"Writing to partition subtype %d at offset 0x%x", partition->subtype, partition->address );
+	return ESP_OK;
+}
+
+char *OtaWriter::getBuffer(){
+	char *b = nullptr;
+	if( pid )
+		xQueueReceive( freeQ, &b, portMAX_DELAY );
+	return b;
+}
+
+void OtaWriter::submit( char *buf, size_t len, size_t from ){
+	t_ota_chunk c = { buf, from, len - from, _submitted };
+	_submitted += len - from;
+	xQueueSend( fullQ, &c, portMAX_DELAY );
+}
+
+void OtaWriter::release( char *buf ){
+	xQueueSend( freeQ, &buf, portMAX_DELAY );
+}
+
+// sends the stop marker and waits until the writer has written everything
+void OtaWriter::stop(){
+	if( !pid )
+		return;
+	t_ota_chunk c = { nullptr, 0, 0, 0 };
+	xQueueSend( fullQ, &c, portMAX_DELAY );
+	xSemaphoreTake( done, portMAX_DELAY );
+	pid = 0;
+}
+
+esp_err_t OtaWriter::end(){
+	stop();
+	esp_err_t err = _err;
+	if( err == ESP_OK )
+		err = OtaDecoder::finish();
+	OtaDecoder::release();
+	if( err != ESP_OK ){
+		abort();
+		return err;
+	}
+	const esp_partition_pos_t pos = { partition->address, partition->size };
+	esp_image_metadata_t image;
+	err = esp_image_verify( ESP_IMAGE_VERIFY, &pos, &image );
+	if( err != ESP_OK )
+		ESP_LOGE(FNAME,"Image verification failed: %s", esp_err_to_name(err) );
+	else
+		err = esp_ota_set_boot_partition( partition );
+	free( buffers );
+	buffers = nullptr;
+	return err;
+}
+
+void OtaWriter::abort(){
+	stop();
+	OtaDecoder::release();
+	free( buffers );
+	buffers = nullptr;
+}
+
+// erase whole sectors up to end, called from the writer task only
+esp_err_t OtaWriter::eraseTo( size_t end ){
+	end = std::min( (end + SPI_FLASH_SEC_SIZE - 1) & ~(SPI_FLASH_SEC_SIZE - 1), (size_t)partition->size );
+	if( end <= erased )
+		return ESP_OK;
+	esp_err_t err = esp_partition_erase_range( partition, erased, end - erased );
+	if( err == ESP_OK )
+		erased = end;
+	return err;
+}
+
+// decoded image data from OtaDecoder, called in the writer task
+esp_err_t OtaWriter::write( const uint8_t *data, size_t len ){
+	if( written == 0 && len && data[0] != ESP_IMAGE_HEADER_MAGIC )
+		return ESP_ERR_OTA_VALIDATE_FAILED;
+	esp_err_t err = eraseTo( written + len );
+	if( err == ESP_OK )
+		err = esp_partition_write( partition, written, data, len );
+	if( err != ESP_OK )
+		ESP_LOGE(FNAME,"OTA write at 0x%x failed: %s", written, esp_err_to_name(err) );
+	written += len;
+	return err;
+}
+
+void OtaWriter::writerTask( void *pvParameters ){
+	t_ota_chunk c;
+	while( true ){
+		if( OtaDecoder::imageSize() )
+			limit = OtaDecoder::imageSize();
+		// nothing to write: erase a bit more ahead of the cursor instead of waiting
+		bool ahead = _err == ESP_OK && erased < limit && erased < written + OTA_ERASE_AHEAD;
+		if( xQueueReceive( fullQ, &c, ahead ? 0 : portMAX_DELAY ) != pdTRUE ){
+			_err = eraseTo( std::min( erased + OTA_ERASE_BLOCK, limit ) );
+			continue;
+		}
+		if( c.buf == nullptr )
+			break;
+		if( _err == ESP_OK )
+			_err = OtaDecoder::feed( (const uint8_t *)c.buf + c.from, c.len );
+		xQueueSend( freeQ, &c.buf, portMAX_DELAY );
+	}
+	xSemaphoreGive( done );
+	vTaskDelete( NULL );
+}
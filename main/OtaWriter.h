@@ -0,0 +1,69 @@
+/*
+ * OtaWriter.h
+ *
+ * Pipelined OTA flashing: the http handler receives into one buffer while
+ * the otaWriter task writes the other one to flash. Whenever the writer
+ * has nothing to write, it erases the partition ahead of the write cursor,
+ * so neither network receive nor flash write waits for a large erase.
+ * The upload is decoded on the way by OtaDecoder (plain or packed image).
+ *
+ *   OtaWriter::begin( size );
+ *   char *buf = OtaWriter::getBuffer();   // fill up to OTA_BUF_SIZE bytes
+ *   OtaWriter::submit( buf, len );     // or release( buf ) if not needed
+ *   ...
+ *   OtaWriter::end();                    // drain, validate, set boot partition
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <esp_err.h>
+#include <esp_ota_ops.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#define OTA_BUF_SIZE     8192       // one pipeline buffer
+#define OTA_NUM_BUFS     4          // one chunk in flight while the next one is received
+#define OTA_CHUNK_MAX    (OTA_NUM_BUFS/2*OTA_BUF_SIZE)  // max. verified upload chunk
+#define OTA_ERASE_BLOCK  16384      // erase step while idle, keeps writer latency low
+#define OTA_ERASE_AHEAD  65536      // max. erased area in front of the write cursor
+
+class OtaWriter {
+public:
+	static esp_err_t begin( size_t upload_size );  // upload_size 0 if unknown
+	static char *getBuffer();                      // blocks until a buffer is free, nullptr if not started
+	static void submit( char *buf, size_t len, size_t from=0 );  // hands buf[from..len) over to the writer
+	static void release( char *buf );              // gives back a buffer unwritten, e.g. on bad CRC
+	static esp_err_t end();                        // waits until all is written, then validates and sets boot partition
+	static void abort();
+	static inline bool active() { return pid != 0; }
+	static inline esp_err_t error() { return _err; }
+	static inline size_t submitted() { return _submitted; }
+
+private:
+	typedef struct {
+		char   *buf;                               // nullptr: stop writer
+		size_t from;                               // data starts at buf+from
+		size_t len;
+		size_t offset;
+	} t_ota_chunk;
+
+	static void writerTask( void *pvParameters );
+	static esp_err_t eraseTo( size_t end );
+	static esp_err_t write( const uint8_t *data, size_t len );
+	static void stop();
+
+	static const esp_partition_t *partition;
+	static char *buffers;
+	static QueueHandle_t freeQ;
+	static QueueHandle_t fullQ;
+	static SemaphoreHandle_t done;
+	static TaskHandle_t pid;
+	static size_t limit;                           // end of the area to be erased
+	static size_t erased;
+	static size_t written;                         // decoded image bytes written
+	static size_t _submitted;
+	static volatile esp_err_t _err;
+};
@@ -34,7 +34,11 @@ some sentences might be lost or truncated.
  */
 
 
-bool Serial::_selfTest = false;
+volatile int Serial::selftest_state = SELFTEST_IDLE;
+unsigned int Serial::selftest_seq = 0;
+unsigned long Serial::selftest_time = 0;
+int Serial::selftest_interval = 0;
+void (*Serial::selftest_done)( bool passed ) = nullptr;
 EventGroupHandle_t Serial::rxTxNotifier = 0;
 
 // Event group bits
@@ -60,6 +64,7 @@ RingBufCPP<SString, QUEUE_SIZE> s1_tx_q;
 RingBufCPP<SString, QUEUE_SIZE> s1_rx_q;
 
 static xSemaphoreHandle qMutex=NULL;
+static xSemaphoreHandle uartMutex=NULL;  // serialHandler against reconfigure()
 
 char Serial::framebuffer[128];
 int  Serial::pos = 0;
@@ -70,6 +75,11 @@ const uart_port_t uart_num = UART_NUM_1;
 bool Serial::bincom_mode = false;  // we start with bincom timer inactive
 int Serial::trials=0;
 int Serial::baudrate = 0;
+int Serial::umask = 0;
+int Serial::cfg_speed = 0;
+int Serial::cfg_umask = 0;
+int Serial::pins = 0;
+bool Serial::hunt_inverted = false;
 
 int Serial::pullBlock( RingBufCPP<SString, QUEUE_SIZE>& q, char *block, int size ){
         xSemaphoreTake(qMutex,portMAX_DELAY );
@@ -130,7 +140,10 @@ void Serial::parse_NMEA( char c ){
 				pos++;
 				framebuffer[pos] = 0;  // framebuffer is zero terminated
 				// pos++;
-				if( !Flarm::getSim() )
+				if( selfTestCheck( framebuffer ) ){
+					// own loop test frame, not for Flarm
+				}
+				else if( !Flarm::getSim() )
 					Flarm::parseNMEA( framebuffer, pos );
 				state = GET_NMEA_SYNC;
 				pos = 0;
@@ -149,19 +162,17 @@ void Serial::serialHandler(void *pvParameters)
 {
 	char buf[512];  // 6 messages @ 80 byte
 	// Make a pause, that has avoided core dumps during enable the RX interrupt.
-	delay( 1000 );  // delay a bit serial task startup unit startup of system is through
+	delay( fast_start.get() ? 100 : 1000 );  // delay a bit serial task startup unit startup of system is through
 	ESP_LOGI(FNAME,"S1 serial handler startup");
 
 	while( true ) {
 		// Stack supervision
 		if( uxTaskGetStackHighWaterMark( pid ) < 256 )
 			ESP_LOGW(FNAME,"Warning serial task stack low: %d bytes", uxTaskGetStackHighWaterMark( pid ) );
-		if( _selfTest ) {
-			delay( 100 );
-			continue;
-		}
+		xSemaphoreTake(uartMutex, portMAX_DELAY );
 		// TX part, check if there is data for Serial Interface to send
-		if( uart_wait_tx_done(uart_num, 100) ) {
+		if( uart_wait_tx_done(uart_num, 100) == ESP_OK ) {
+			selfTestTick();
 			int len = pullBlock( s1_tx_q, buf, 512 );
 			if( len ){
 				// ESP_LOGI(FNAME,"S1: TX len: %d bytes",  len );
@@ -181,57 +192,75 @@ void Serial::serialHandler(void *pvParameters)
 			buf[rxBytes] = 0;
 			process( buf, rxBytes );
 		}
-		if( !Flarm::connected() ){
-			huntBaudrate();
-		}
+		huntBaudrate();  // hunts while disconnected, persists what it found once connected
+		xSemaphoreGive(uartMutex);
 		delay( 100 );
 	} // end while( true )
 }
 
 
-bool Serial::selfTest(){
-	ESP_LOGI(FNAME,"Serial S1 selftest");
-	delay(100);  // wait for serial hardware init
-	_selfTest = true;
-	std::string test( PROGMEM "The quick brown fox jumps over the lazy dog" );
-	int tx = 0;
-	uart_flush(uart_num);
-	if( uart_wait_tx_done(uart_num, 5000) == ESP_OK ) {
-		tx = uart_write_bytes(uart_num, (const char*)test.c_str(), test.length() );
-		ESP_LOGI(FNAME,"Serial TX written: %d", tx );
-	}
-	else {
-		ESP_LOGI(FNAME,"Serial not avail for sending, abort");
-		return false;
-	}
-	char recv[256];
-	memset(recv,0,256);
-	delay( 10 );
-	int numread = 0;
-	for( int i=1; i<10; i++ ){
-		int avail = 0;
-		uart_get_buffered_data_len(uart_num, (size_t*)&avail);
-		ESP_LOGI(FNAME,"Serial RX bytes avail: %d", avail );
-		if( avail >= tx ){
-			if( avail > 256 )
-				avail = 256;
-			numread = uart_read_bytes(uart_num, recv, avail, 256);
-			ESP_LOGI(FNAME,"Serial RX bytes read: %d %s", numread, recv );
-			break;
-		}
-		delay( 10 );
-	}
-	_selfTest = false;
-	std::string r( recv );
-	if( r.find( test ) != std::string::npos )  {
+// Loop test frame, send out on TX and recognised by parse_NMEA() on RX,
+// normal reception goes on meanwhile. $PXCFT is not known to any Flarm.
+#define SELFTEST_TIMEOUT 1000  // ms
+
+void Serial::selfTest( void (*done)( bool passed ), int interval_ms ){
+	ESP_LOGI(FNAME,"Serial S1 selftest requested, interval %d ms", interval_ms );
+	selftest_done = done;
+	selftest_interval = interval_ms;
+	selftest_state = SELFTEST_REQUESTED;  // handler task picks that up
+}
+
+// called from serialHandler with the UART mutex held
+void Serial::selfTestSend(){
+	selftest_seq = (selftest_seq + 1) & 0xffff;
+	char frame[24];
+	int len = snprintf( frame, sizeof(frame), "$PXCFT,%04X", selftest_seq );
+	len += snprintf( frame+len, sizeof(frame)-len, "*%02X\r\n", Flarm::calcNMEACheckSum( frame ) );
+	int tx = uart_write_bytes(uart_num, frame, len );
+	selftest_time = millis();
+	selftest_state = SELFTEST_PENDING;
+	ESP_LOGD(FNAME,"Serial selftest TX written: %d", tx );
+}
+
+void Serial::selfTestResult( bool passed ){
+	selftest_state = passed ? SELFTEST_PASSED : SELFTEST_FAILED;
+	selftest_time = millis();
+	if( passed )
 		ESP_LOGI(FNAME,"Serial Test PASSED");
-		return true;
-	}
-	else {
+	else
 		ESP_LOGI(FNAME,"Serial Test FAILED !");
+	if( selftest_done )
+		(*selftest_done)( passed );
+}
+
+// called per received frame, true if it was our loop test frame
+bool Serial::selfTestCheck( const char *frame ){
+	if( strncmp( frame, "$PXCFT,", 7 ) )
 		return false;
+	unsigned int seq = 0;
+	if( selftest_state == SELFTEST_PENDING && sscanf( frame+7, "%4X", &seq ) == 1 && seq == selftest_seq ){
+		selfTestResult( true );
+	}
+	return true;
+}
+
+void Serial::selfTestTick(){
+	switch( selftest_state ){
+	case SELFTEST_REQUESTED:
+		selfTestSend();
+		break;
+	case SELFTEST_PENDING:
+		if( (millis() - selftest_time) > SELFTEST_TIMEOUT )
+			selfTestResult( false );
+		break;
+	case SELFTEST_PASSED:
+	case SELFTEST_FAILED:
+		if( selftest_interval && (millis() - selftest_time) > (unsigned long)selftest_interval )
+			selfTestSend();
+		break;
+	default:
+		break;
 	}
-	return false;
 }
 
 void Serial::huntBaudrate(){
@@ -239,19 +268,66 @@ void Serial::huntBaudrate(){
 		trials++;
 		if( trials>40 ) { // An active Flarm sends every second at least
 			trials = 0;
-			baudrate++;
-			if( baudrate > 6 ){
-				baudrate=2;  // 9600
+			// try both RX polarities per baudrate, then move on to the next baudrate
+			umask ^= UART_SIGNAL_RXD_INV;
+			hunt_inverted = !hunt_inverted;
+			if( !hunt_inverted ){
+				baudrate++;
+				if( baudrate > 6 ){
+					baudrate=2;  // 9600
+				}
+				uart_set_baudrate(uart_num, baud[baudrate]);
 			}
-			uart_set_baudrate(uart_num, baud[baudrate]);
-			ESP_LOGI(FNAME,"Serial Interface ttyS1 next baudrate: %d", baud[baudrate] );
+			uart_set_line_inverse( uart_num, umask );
+			ESP_LOGI(FNAME,"Serial Interface ttyS1 next baudrate: %d rx_inv: %d", baud[baudrate], (umask & UART_SIGNAL_RXD_INV) != 0 );
 		}
 	}
 	else{
+		// the setup now holds the hunted line state, reconfigure() must not undo it
+		cfg_speed = baudrate;
+		cfg_umask = umask;
+		int rx_inv = (umask & UART_SIGNAL_RXD_INV) ? RS232_INVERTED : RS232_NORMAL;
+		if( serial1_rx_inverted.get() != rx_inv ){
+			ESP_LOGI(FNAME,"Serial RX inversion auto detected: %d", rx_inv );
+			serial1_rx_inverted.set( rx_inv );
+		}
 		if( serial1_speed.get() != baudrate ){
-			ESP_LOGI(FNAME,"Serial baudrate auto detected: %d", baudrate );
+			ESP_LOGI(FNAME,"Serial baudrate auto detected: %d", baud[baudrate] );
 			serial1_speed.set( baudrate );
 		}
+		hunt_inverted = false;
+	}
+}
+
+void Serial::setPins(){
+	pins = (serial1_pins_twisted.get() ? 2 : 0) | (serial1_tx_enable.get() ? 1 : 0);
+	if( baudrate == 0 )
+		return;
+	gpio_pullup_en( GPIO_NUM_16 );
+	gpio_pullup_en( GPIO_NUM_17 );
+	// Pin 38 is standard IGC RX pin, Pin 37 TX pin
+	if( serial1_pins_twisted.get() ){
+		if( serial1_tx_enable.get() ){
+			ESP_LOGI(FNAME,"Serial pins twisted, TX enabled" );
+			ESP_ERROR_CHECK(uart_set_pin(uart_num, GPIO_NUM_38, GPIO_NUM_37, GPIO_NUM_33, GPIO_NUM_34));
+		}else{
+			ESP_LOGI(FNAME,"Serial pins twisted, TX disabled" );
+			ESP_ERROR_CHECK(uart_set_pin(uart_num, GPIO_NUM_36, GPIO_NUM_37, GPIO_NUM_33, GPIO_NUM_34));
+			gpio_set_direction(GPIO_NUM_38, GPIO_MODE_INPUT);     // high impedance
+			gpio_pullup_dis( GPIO_NUM_38 );
+		}
+	}
+	else{
+		if( serial1_tx_enable.get() ){
+			ESP_LOGI(FNAME,"Serial pins normal, TX enabled" );
+			// Set UART pins(TX, RX, RTS, CTS ) RTS and CTS nor wired, dummy
+			ESP_ERROR_CHECK(uart_set_pin(uart_num, GPIO_NUM_37, GPIO_NUM_38, GPIO_NUM_33, GPIO_NUM_34));
+		}else{
+			ESP_LOGI(FNAME,"Serial pins normal, TX disable" );
+			ESP_ERROR_CHECK(uart_set_pin(uart_num, GPIO_NUM_36, GPIO_NUM_38, GPIO_NUM_33, GPIO_NUM_34));
+			gpio_set_direction(GPIO_NUM_37, GPIO_MODE_INPUT);     // high impedance
+			gpio_pullup_dis( GPIO_NUM_37 );
+		}
 	}
 }
 
@@ -259,9 +335,10 @@ void Serial::begin(){
 	ESP_LOGI(FNAME,"Serial::begin()" );
 	// Initialize static configuration
 	qMutex = xSemaphoreCreateMutex();
-	baudrate = baud[serial1_speed.get()];
+	uartMutex = xSemaphoreCreateMutex();
+	baudrate = serial1_speed.get();
 	uart_config_t uart_config = {
-	    .baud_rate = baudrate,
+	    .baud_rate = baud[baudrate],
 	    .data_bits = UART_DATA_8_BITS,
 	    .parity = UART_PARITY_DISABLE,
 	    .stop_bits = UART_STOP_BITS_1,
@@ -271,45 +348,16 @@ void Serial::begin(){
 	};
 
 	ESP_ERROR_CHECK(uart_param_config(uart_num, &uart_config));
-	ESP_LOGI(FNAME,"Serial param config, baudrate=%d", baudrate );
+	ESP_LOGI(FNAME,"Serial param config, baudrate=%d", baud[baudrate] );
 
-	int umask = UART_SIGNAL_INV_DISABLE;
-	if( serial1_tx_inverted.get() )
-		umask |= UART_SIGNAL_TXD_INV;
-	if( serial1_rx_inverted.get() )
-		umask |= UART_SIGNAL_RXD_INV;
+	umask = lineInverse();
+	cfg_speed = baudrate;
+	cfg_umask = umask;
 	if( umask ){
 		ESP_ERROR_CHECK( uart_set_line_inverse( uart_num, umask ) );
 		ESP_LOGI(FNAME,"Serial param line inverse" );
 	}
-	if( baudrate != 0 ) {
-		gpio_pullup_en( GPIO_NUM_16 );
-		gpio_pullup_en( GPIO_NUM_17 );
-		// Pin 38 is standard IGC RX pin, Pin 37 TX pin
-		if( serial1_pins_twisted.get() ){
-			if( serial1_tx_enable.get() ){
-				ESP_LOGI(FNAME,"Serial pins twisted, TX enabled" );
-				ESP_ERROR_CHECK(uart_set_pin(uart_num, GPIO_NUM_38, GPIO_NUM_37, GPIO_NUM_33, GPIO_NUM_34));
-			}else{
-				ESP_LOGI(FNAME,"Serial pins twisted, TX disabled" );
-				ESP_ERROR_CHECK(uart_set_pin(uart_num, GPIO_NUM_36, GPIO_NUM_37, GPIO_NUM_33, GPIO_NUM_34));
-				gpio_set_direction(GPIO_NUM_38, GPIO_MODE_INPUT);     // high impedance
-				gpio_pullup_dis( GPIO_NUM_38 );
-			}
-		}
-		else{
-			if( serial1_tx_enable.get() ){
-				ESP_LOGI(FNAME,"Serial pins normal, TX enabled" );
-				// Set UART pins(TX, RX, RTS, CTS ) RTS and CTS nor wired, dummy
-				ESP_ERROR_CHECK(uart_set_pin(uart_num, GPIO_NUM_37, GPIO_NUM_38, GPIO_NUM_33, GPIO_NUM_34));
-			}else{
-				ESP_LOGI(FNAME,"Serial pins normal, TX disable" );
-				ESP_ERROR_CHECK(uart_set_pin(uart_num, GPIO_NUM_36, GPIO_NUM_38, GPIO_NUM_33, GPIO_NUM_34));
-				gpio_set_direction(GPIO_NUM_37, GPIO_MODE_INPUT);     // high impedance
-				gpio_pullup_dis( GPIO_NUM_37 );
-			}
-		}
-	}
+	setPins();
 	ESP_LOGI(FNAME,"Serial Interface ttyS1 enabled with serial speed: %d baud: %d tx_inv: %d rx_inv: %d",  serial1_speed.get(), baud[serial1_speed.get()], serial1_tx_inverted.get(), serial1_rx_inverted.get() );
 
 
@@ -320,6 +368,67 @@ void Serial::begin(){
 	ESP_ERROR_CHECK(uart_driver_install(uart_num, uart_buffer_size, uart_buffer_size, 10, &uart_queue, 0));
     taskStart();
 
+	// apply later changes of the line setup live, delivered by the setupNotify task
+	serial1_speed.attach( configChanged, nullptr, true );
+	serial1_tx_inverted.attach( configChanged, nullptr, true );
+	serial1_rx_inverted.attach( configChanged, nullptr, true );
+	serial1_pins_twisted.attach( configChanged, nullptr, true );
+	serial1_tx_enable.attach( configChanged, nullptr, true );
+}
+
+int Serial::lineInverse(){
+	int umask = UART_SIGNAL_INV_DISABLE;
+	if( serial1_tx_inverted.get() )
+		umask |= UART_SIGNAL_TXD_INV;
+	if( serial1_rx_inverted.get() )
+		umask |= UART_SIGNAL_RXD_INV;
+	return umask;
+}
+
+// Apply the serial1_* setup to the running UART. Driver, task and queues stay alive,
+// only settings that differ from what was last applied or auto detected are touched,
+// so a line state found by huntBaudrate() survives changes of the other settings.
+bool Serial::reconfigure(){
+	xSemaphoreTake(uartMutex, portMAX_DELAY );
+	bool changed = false;
+	uart_wait_tx_done(uart_num, 100);
+	int speed = serial1_speed.get();
+	if( speed != cfg_speed && speed > 0 && speed < (int)(sizeof(baud)/sizeof(baud[0])) ){
+		ESP_LOGI(FNAME,"Serial reconfigure baudrate %d -> %d", baud[baudrate], baud[speed] );
+		cfg_speed = speed;
+		baudrate = speed;
+		uart_set_baudrate(uart_num, baud[baudrate]);
+		changed = true;
+	}
+	int mask = lineInverse();
+	if( mask != cfg_umask ){
+		int bits = mask ^ cfg_umask;  // only what was changed in the setup
+		ESP_LOGI(FNAME,"Serial reconfigure line inverse %x -> %x", umask, (umask & ~bits) | (mask & bits) );
+		cfg_umask = mask;
+		umask = (umask & ~bits) | (mask & bits);
+		uart_set_line_inverse( uart_num, umask );
+		changed = true;
+	}
+	int p = (serial1_pins_twisted.get() ? 2 : 0) | (serial1_tx_enable.get() ? 1 : 0);
+	if( p != pins ){
+		setPins();
+		changed = true;
+	}
+	if( changed ){
+		// whatever was on the wire during the switch is garbage
+		uart_flush_input(uart_num);
+		state = GET_NMEA_SYNC;
+		pos = 0;
+		trials = 0;
+		hunt_inverted = false;
+	}
+	xSemaphoreGive(uartMutex);
+	return changed;
+}
+
+void Serial::configChanged( SetupNG<int> *item, int oldval, int newval, void *arg ){
+	ESP_LOGI(FNAME,"Serial config %s changed %d -> %d", item->key(), oldval, newval );
+	reconfigure();
 }
 
 void Serial::taskStart(){
@@ -17,6 +17,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include "HardwareSerial.h"
+#include "SetupNG.h"
 
 #define SERIAL_STRLEN SSTRLEN
 
@@ -34,6 +35,15 @@
 
 const int baud[] = { 0, 4800, 9600, 19200, 38400, 57600, 115200 };
 
+// loop test states
+enum selftest_t {
+	SELFTEST_IDLE,
+	SELFTEST_REQUESTED,
+	SELFTEST_PENDING,
+	SELFTEST_PASSED,
+	SELFTEST_FAILED
+};
+
 // state machine definition
 enum state_t {
 	GET_NMEA_SYNC,
@@ -49,15 +59,30 @@ public:
 	static void begin();
 	static void taskStart();
 	static void serialHandler(void *pvParameters);
-	static bool selfTest();
+	// non blocking loop test, result is reported via done() from the serial task,
+	// with interval_ms > 0 the test repeats while normal reception goes on
+	static void selfTest( void (*done)( bool passed )=nullptr, int interval_ms=0 );
+	static inline int selfTestState() { return selftest_state; }
 	static int  pullBlock( RingBufCPP<SString, QUEUE_SIZE>& q, char *block, int size );
 	static void process( const char *packet, int len );
 	static void parse_NMEA( char c );
 	static void huntBaudrate();
+	static bool reconfigure();
+	static void configChanged( SetupNG<int> *item, int oldval, int newval, void *arg );
 
 private:
+	static int lineInverse();
+	static void setPins();
 	static enum state_t state;
-	static bool _selfTest;
+	static void selfTestSend();
+	static void selfTestTick();
+	static bool selfTestCheck( const char *frame );
+	static void selfTestResult( bool passed );
+	static volatile int selftest_state;
+	static unsigned int selftest_seq;
+	static unsigned long selftest_time;
+	static int selftest_interval;
+	static void (*selftest_done)( bool passed );
 	static EventGroupHandle_t rxTxNotifier;
 	// Stop routing of TX/RX data. That is used in case of Flarm binary download.
 	static bool bincom_mode;
@@ -66,7 +91,12 @@ private:
 	static int  len;
 	static TaskHandle_t pid;
 	static int trials;
-	static int baudrate;
+	static int baudrate;  // index into baud[]
+	static int umask;     // active UART line inversion
+	static int cfg_speed; // serial1_speed last applied or auto detected
+	static int cfg_umask; // line inversion of the setup last applied or auto detected
+	static int pins;      // active pin setup, bit1: twisted, bit0: TX enabled
+	static bool hunt_inverted;
 };
 
 #endif
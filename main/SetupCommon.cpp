@@ -66,12 +66,12 @@ bool SetupCommon::syncEntry( int entry ){
 
 void SetupCommon::giveConfigChanges( httpd_req *req, bool log_only ){
 	ESP_LOGI(FNAME,"giveConfigChanges");
-	char cfg[50];
+	char cfg[16+SETUP_VALUE_STRLEN+2];  // key max 15 char, comma, value, newline
 	for(int i = 0; i < instances->size(); i++ ) {
 		if( (*instances)[i]->isDefault() == false ){
-			char val[20];
-			if( (*instances)[i]->value_str( val ) ){
-				sprintf( cfg, "%s,%s\n", (*instances)[i]->key(), val );
+			char val[SETUP_VALUE_STRLEN];
+			if( (*instances)[i]->value_str( val, sizeof(val) ) ){
+				snprintf( cfg, sizeof(cfg), "%s,%s\n", (*instances)[i]->key(), val );
 				ESP_LOGI(FNAME,"%s,%s", (*instances)[i]->key(), val );
 				if( !log_only )
 					httpd_resp_send_chunk( req, cfg, strlen(cfg) );
@@ -109,8 +109,13 @@ int SetupCommon::restoreConfigChanges( int len, char *data ){
 			std::string value = line.substr(line.find(',')+1, line.length());
 			printf( "%d %s ", i, key.c_str()  );
 			SetupCommon * item = getMember( key.c_str() );
+			if( !item ){
+				ESP_LOGW(FNAME,"unknown key %s, skipped", key.c_str() );
+				continue;
+			}
 			printf( ", typename: %c \n", item->typeName()  );
-			item->setValueStr( value.c_str() );
+			if( !item->setValueStr( value.c_str() ) )
+				continue;
 			item->commit();  // lets do that lazy later
 			i++;
 		}
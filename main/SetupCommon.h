@@ -37,10 +37,10 @@ public:
 	virtual bool erase() = 0;
 	virtual bool write() = 0;
 	virtual bool commit() = 0;
-	virtual void setValueStr( const char * val ) = 0;
+	virtual bool setValueStr( const char * val ) = 0;
 	virtual bool mustReset() = 0;
 	virtual bool isDefault() = 0;
-	virtual bool value_str(char *str) = 0;
+	virtual bool value_str( char *str, size_t len ) = 0;
 	virtual const char* key() = 0;
 	virtual char typeName() = 0;
 	virtual bool sync() = 0;
@@ -0,0 +1,223 @@
+/*
+ * SetupFormat.h
+ *
+ * Typed, allocation free value <-> text conversion for SetupNG<T>.
+ * The matching formatter is selected at compile time per T, no typeid()
+ * and no sprintf/sscanf into unbounded buffers. Output is always bounded
+ * by the length given by the caller and zero terminated.
+ *
+ * Supported: int and any other integral type, enums (e.g. uint8_t based),
+ * bool, float, fixed size strings SetupString<N> and fixed byte arrays
+ * std::array<uint8_t,N> (hex encoded).
+ */
+
+#pragma once
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <array>
+#include <limits>
+#include <type_traits>
+
+// max. length of a config value in text form incl. terminator
+#define SETUP_VALUE_STRLEN 32
+
+// fixed size, zero terminated string to be stored as config item
+template<size_t N> struct SetupString
+{
+	char str[N];
+
+	SetupString() { str[0] = 0; }
+	SetupString( const char *s ) { set( s ); }
+	inline void set( const char *s ) {
+		strncpy( str, s, N-1 );
+		str[N-1] = 0;
+	}
+	inline const char *c_str() const { return str; }
+	inline bool operator==( const SetupString &r ) const { return strncmp( str, r.str, N ) == 0; }
+	inline bool operator!=( const SetupString &r ) const { return !(*this == r); }
+};
+
+// helpers shared by the formatters
+namespace setupfmt {
+
+	// unsigned decimal, written right to left into a scratch, then copied
+	inline bool utoa( unsigned long v, bool neg, char *str, size_t len ){
+		char tmp[24];
+		int p = sizeof(tmp);
+		do {
+			tmp[--p] = '0' + (v % 10);
+			v /= 10;
+		} while( v );
+		if( neg )
+			tmp[--p] = '-';
+		size_t n = sizeof(tmp) - p;
+		if( n >= len )
+			return false;
+		memcpy( str, &tmp[p], n );
+		str[n] = 0;
+		return true;
+	}
+
+	// true if only white space (e.g. CR of a CSV line) follows the number
+	inline bool trailingSpace( const char *end ){
+		while( *end == ' ' || *end == '\t' || *end == '\r' || *end == '\n' )
+			end++;
+		return *end == 0;
+	}
+
+	// true if str is exactly the token t, up to trailing white space
+	inline bool token( const char *str, const char *t ){
+		size_t n = strlen( t );
+		return !strncmp( str, t, n ) && trailingSpace( str + n );
+	}
+
+	// integral type an enum is stored in, T itself for integral types
+	template<typename T, bool = std::is_enum<T>::value> struct underlying { typedef typename std::underlying_type<T>::type type; };
+	template<typename T> struct underlying<T, false> { typedef T type; };
+
+	inline int hexNibble( char c ){
+		if( c >= '0' && c <= '9' ) return c - '0';
+		if( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+		if( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+		return -1;
+	}
+}
+
+// not supported type: nothing to print, nothing to restore
+template<typename T, typename Enable = void> struct SetupFormat
+{
+	static char typeName() { return 'U'; }
+	static bool toStr( const T &v, char *str, size_t len ) { return false; }
+	static bool fromStr( const char *str, T &v ) { return false; }
+};
+
+// int, uint8_t, ... and enums, decimal
+template<typename T> struct SetupFormat<T, typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type>
+{
+	static char typeName() { return 'I'; }
+	static bool toStr( const T &v, char *str, size_t len ) {
+		if( std::is_unsigned<T>::value )
+			return setupfmt::utoa( (unsigned long)v, false, str, len );
+		long l = (long)v;
+		if( l < 0 )
+			return setupfmt::utoa( -(unsigned long)l, true, str, len );
+		return setupfmt::utoa( (unsigned long)l, false, str, len );
+	}
+	// out of range for T is an error, not silently truncated
+	static bool fromStr( const char *str, T &v ) {
+		typedef typename setupfmt::underlying<T>::type U;
+		char *end;
+		errno = 0;
+		if( std::is_unsigned<U>::value ){
+			if( strchr( str, '-' ) )  // strtoull() would wrap negative numbers
+				return false;
+			unsigned long long u = strtoull( str, &end, 10 );
+			if( end == str || errno == ERANGE || !setupfmt::trailingSpace( end ) || u > (unsigned long long)std::numeric_limits<U>::max() )
+				return false;
+			v = (T)(U)u;
+		}
+		else{
+			long long l = strtoll( str, &end, 10 );
+			if( end == str || errno == ERANGE || !setupfmt::trailingSpace( end ) ||
+					l < (long long)std::numeric_limits<U>::min() || l > (long long)std::numeric_limits<U>::max() )
+				return false;
+			v = (T)(U)l;
+		}
+		return true;
+	}
+};
+
+template<> struct SetupFormat<bool>
+{
+	static char typeName() { return 'B'; }
+	static bool toStr( const bool &v, char *str, size_t len ) {
+		if( len < 2 )
+			return false;
+		str[0] = v ? '1' : '0';
+		str[1] = 0;
+		return true;
+	}
+	static bool fromStr( const char *str, bool &v ) {
+		if( setupfmt::token( str, "1" ) || setupfmt::token( str, "true" ) ){
+			v = true;
+			return true;
+		}
+		if( setupfmt::token( str, "0" ) || setupfmt::token( str, "false" ) ){
+			v = false;
+			return true;
+		}
+		return false;
+	}
+};
+
+template<> struct SetupFormat<float>
+{
+	static char typeName() { return 'F'; }
+	static bool toStr( const float &v, char *str, size_t len ) {
+		int n = snprintf( str, len, "%f", v );
+		return n > 0 && (size_t)n < len;
+	}
+	static bool fromStr( const char *str, float &v ) {
+		char *end;
+		float f = strtof( str, &end );
+		if( end == str || !setupfmt::trailingSpace( end ) )
+			return false;
+		v = f;
+		return true;
+	}
+};
+
+template<size_t N> struct SetupFormat<SetupString<N>>
+{
+	static char typeName() { return 'S'; }
+	static bool toStr( const SetupString<N> &v, char *str, size_t len ) {
+		size_t n = strnlen( v.str, N );
+		if( n >= len )
+			return false;
+		memcpy( str, v.str, n );
+		str[n] = 0;
+		return true;
+	}
+	static bool fromStr( const char *str, SetupString<N> &v ) {
+		size_t n = strcspn( str, "\r\n" );
+		if( n >= N )
+			return false;
+		memcpy( v.str, str, n );
+		v.str[n] = 0;
+		return true;
+	}
+};
+
+template<size_t N> struct SetupFormat<std::array<uint8_t,N>>
+{
+	static char typeName() { return 'H'; }
+	static bool toStr( const std::array<uint8_t,N> &v, char *str, size_t len ) {
+		static const char hex[] = "0123456789ABCDEF";
+		if( 2*N >= len )
+			return false;
+		for( size_t i=0; i<N; i++ ){
+			str[2*i]   = hex[v[i] >> 4];
+			str[2*i+1] = hex[v[i] & 0x0f];
+		}
+		str[2*N] = 0;
+		return true;
+	}
+	static bool fromStr( const char *str, std::array<uint8_t,N> &v ) {
+		std::array<uint8_t,N> t;
+		for( size_t i=0; i<N; i++ ){
+			int h = setupfmt::hexNibble( str[2*i] );
+			int l = (h < 0) ? -1 : setupfmt::hexNibble( str[2*i+1] );
+			if( l < 0 )
+				return false;
+			t[i] = (h << 4) | l;
+		}
+		if( !setupfmt::trailingSpace( &str[2*N] ) )
+			return false;
+		v = t;
+		return true;
+	}
+};
@@ -56,4 +56,5 @@ SetupNG<int>  			display_orientation("DISPLAY_ORIENT" , DISPLAY_NORMAL );
 SetupNG<int>  			display_mode("DISPLAY_MODE" , DISPLAY_MULTI );
 SetupNG<int>  			display_non_moving_target("NON_MOVE" , NON_MOVE_HIDE );
 SetupNG<int>  			notify_near( "NOTFNEAR", BUZZ_2KM );
+SetupNG<int>  			fast_start( "FAST_START", 0 );
 
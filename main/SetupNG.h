@@ -26,6 +26,8 @@
 #include <vector>
 #include "logdef.h"
 #include "SetupCommon.h"
+#include "SetupFormat.h"
+#include "SetupNotify.h"
 #include "ESP32NVS.h"
 
 
@@ -79,11 +81,7 @@ template<typename T> class SetupNG: public SetupCommon
 {
 	public:
 	char typeName(void){
-		if( typeid( T ) == typeid( float ) )
-			return 'F';
-		else if( typeid( T ) == typeid( int ) )
-			return 'I';
-		return 'U';
+		return SetupFormat<T>::typeName();
 	}
 	SetupNG( const char * akey,
 			T adefault,  				   // unique identification TAG
@@ -112,21 +110,21 @@ template<typename T> class SetupNG: public SetupCommon
 		return flags._dirty;
 	}
 
-	virtual void setValueStr( const char * val ){
+	virtual bool setValueStr( const char * val ){
 		if( flags._volatile != VOLATILE ){
-			if( typeid( T ) == typeid( float ) ){
-				float t;
-				sscanf( val,"%f", &t );
-				memcpy((char *)&_value, &t, sizeof(t) );
-			}
-			else if( typeid( T ) == typeid( int ) ){
-				int t;
-				sscanf( val,"%d", &t );
-				memcpy((char *)&_value, &t, sizeof(t) );
+			T t = _value;
+			if( !SetupFormat<T>::fromStr( val, t ) ){
+				ESP_LOGW(FNAME,"%s: invalid value '%s'", _key, val );
+				return false;
 			}
+			T old = _value;
+			_value = t;
 			flags._dirty = true;
+			if( !(old == _value) )
+				SetupNotify::notify( this, &old, &_value, sizeof(T) );
+			return true;
 		}
-
+		return false;
 	}
 
 	inline T* getPtr() {
@@ -145,20 +143,9 @@ template<typename T> class SetupNG: public SetupCommon
 	virtual T getGui() const { return get(); } // tb. overloaded for blackboard
 	virtual const char* unit() const { return ""; } // tb. overloaded for blackboard
 
-	virtual bool value_str(char *str){
+	virtual bool value_str( char *str, size_t len ){
 		if( flags._volatile != VOLATILE ){
-			if( typeid( T ) == typeid( float ) ){
-				float t;
-				memcpy(&t, &_value, sizeof(t) );
-				sprintf( str,"%f", t );
-				return true;
-			}
-			else if( typeid( T ) == typeid( int ) ){
-				int t;
-				memcpy(&t, &_value, sizeof(t) );
-				sprintf( str,"%d", t );
-				return true;
-			}
+			return SetupFormat<T>::toStr( _value, str, len );
 		}
 		return false;
 	}
@@ -168,6 +155,7 @@ template<typename T> class SetupNG: public SetupCommon
 			// ESP_LOGI(FNAME,"Value already in config: %s", _key );
 			return( true );
 		}
+		T old = _value;
 		_value = aval;
 		if ( dosync ) {
 			sync();
@@ -176,6 +164,7 @@ template<typename T> class SetupNG: public SetupCommon
 			if( _action != 0 ) {
 				(*_action)();
 			}
+			SetupNotify::notify( this, &old, &_value, sizeof(T) );
 		}
 		if( flags._volatile == VOLATILE ){
 			return true;
@@ -185,6 +174,16 @@ template<typename T> class SetupNG: public SetupCommon
 		return true;
 	}
 
+	// typed change observer, see SetupNotify.h
+	typedef void (*observer_t)( SetupNG<T> *item, T oldval, T newval, void *arg );
+
+	bool attach( observer_t cb, void *arg=nullptr, bool deferred=false ) {
+		return SetupNotify::attach( this, &dispatch, (void (*)())cb, arg, deferred, sizeof(T) );
+	}
+	void detach( observer_t cb ) {
+		SetupNotify::detach( this, (void (*)())cb );
+	}
+
 	e_unit_type_t unitType() {
 		return (e_unit_type_t)flags._unit;
 	}
@@ -216,8 +215,9 @@ template<typename T> class SetupNG: public SetupCommon
 
 	bool write() { // do the set blob that actually seems to write to the flash either
 		// ESP_LOGI(FNAME,"NVS write(): ");
-		char val[30];
-		value_str(val);
+		char val[SETUP_VALUE_STRLEN];
+		if( !value_str( val, sizeof(val) ) )
+			val[0] = 0;
 		ESP_LOGI(FNAME,"NVS set blob(key:%s, val: %s, len:%d )", _key, val, sizeof( _value ) );
 		bool ret = NVS.setBlob( _key, (void *)(&_value), sizeof( _value ) );
 		if( !ret )
@@ -266,8 +266,8 @@ template<typename T> class SetupNG: public SetupCommon
 					commit();
 				}
 				else {
-					// char val[30];
-					// value_str(val);
+					// char val[SETUP_VALUE_STRLEN];
+					// value_str( val, sizeof(val) );
 					// ESP_LOGI(FNAME,"NVS key %s exists len: %d, value: %s", _key, required_size, val );
 				}
 			}
@@ -304,6 +304,13 @@ template<typename T> class SetupNG: public SetupCommon
 	inline uint8_t getSync() { return flags._sync; }
 
 private:
+	static void dispatch( void (*cb)(), SetupCommon *item, const void *oldval, const void *newval, void *arg ) {
+		T o, n;
+		memcpy( (void *)&o, oldval, sizeof(T) );
+		memcpy( (void *)&n, newval, sizeof(T) );
+		(*(observer_t)cb)( static_cast<SetupNG<T> *>(item), o, n, arg );
+	}
+
 	T _value;
 	T _default;
 	const char * _key;
@@ -340,5 +347,6 @@ extern SetupNG<int>  		display_orientation;
 extern SetupNG<int>  		display_mode;
 extern SetupNG<int>  		display_non_moving_target;
 extern SetupNG<int>  		notify_near;
+extern SetupNG<int>  		fast_start;
 
 
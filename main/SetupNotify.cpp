@@ -0,0 +1,121 @@
+/*
+ * SetupNotify.cpp
+ *
+ * Observer table and deferred delivery task for SetupNG config changes.
+ */
+
+#include "SetupNotify.h"
+#include "freertos/task.h"
+#include <cstring>
+#include <logdef.h>
+
+typedef struct setup_event {
+	int     idx;                            // index into observer table
+	SetupCommon *item;                      // observer the event was queued for, dropped
+	void    (*cb)();                        // if the slot was detached or reused since
+	uint8_t oldval[SETUP_NOTIFY_VALSIZE];
+	uint8_t newval[SETUP_NOTIFY_VALSIZE];
+} t_setup_event;
+
+t_setup_observer SetupNotify::observers[SETUP_MAX_OBSERVERS];
+int SetupNotify::numObservers = 0;
+int SetupNotify::_dropped = 0;
+QueueHandle_t SetupNotify::queue = 0;
+TaskHandle_t SetupNotify::pid = 0;
+
+static portMUX_TYPE notifyMux = portMUX_INITIALIZER_UNLOCKED;
+
+bool SetupNotify::attach( SetupCommon *item, setup_dispatch_t dispatch, void (*cb)(), void *arg, bool deferred, size_t valsize ){
+	if( deferred ){
+		if( valsize > SETUP_NOTIFY_VALSIZE ){
+			ESP_LOGE(FNAME,"value size %d too big for deferred notification", valsize );
+			return false;
+		}
+		startTask();
+	}
+	portENTER_CRITICAL( &notifyMux );
+	int slot = -1;
+	for( int i=0; i<numObservers; i++ ){  // reuse a detached slot first
+		if( observers[i].item == nullptr ){
+			slot = i;
+			break;
+		}
+	}
+	if( slot < 0 && numObservers < SETUP_MAX_OBSERVERS )
+		slot = numObservers;
+	if( slot >= 0 ){
+		observers[slot].dispatch = dispatch;
+		observers[slot].cb = cb;
+		observers[slot].arg = arg;
+		observers[slot].deferred = deferred;
+		observers[slot].item = item;  // valid from now on
+		if( slot == numObservers )
+			numObservers++;
+	}
+	portEXIT_CRITICAL( &notifyMux );
+	if( slot < 0 ){
+		ESP_LOGE(FNAME,"observer table full");
+		return false;
+	}
+	return true;
+}
+
+void SetupNotify::detach( SetupCommon *item, void (*cb)() ){
+	portENTER_CRITICAL( &notifyMux );
+	for( int i=0; i<numObservers; i++ ){
+		if( observers[i].item == item && observers[i].cb == cb )
+			observers[i].item = nullptr;
+	}
+	portEXIT_CRITICAL( &notifyMux );
+}
+
+void SetupNotify::notify( SetupCommon *item, const void *oldval, const void *newval, size_t valsize ){
+	for( int i=0; ; i++ ){
+		portENTER_CRITICAL( &notifyMux );  // attach() and detach() may rewrite the slot meanwhile
+		if( i >= numObservers ){
+			portEXIT_CRITICAL( &notifyMux );
+			break;
+		}
+		t_setup_observer o = observers[i];
+		portEXIT_CRITICAL( &notifyMux );
+		if( o.item != item )
+			continue;
+		if( !o.deferred ){
+			(*o.dispatch)( o.cb, item, oldval, newval, o.arg );
+			continue;
+		}
+		t_setup_event ev;
+		ev.idx = i;
+		ev.item = o.item;
+		ev.cb = o.cb;
+		memcpy( ev.oldval, oldval, valsize );
+		memcpy( ev.newval, newval, valsize );
+		if( xQueueSend( queue, &ev, 0 ) != pdTRUE )  // never block the setter
+			_dropped++;
+	}
+}
+
+void SetupNotify::startTask(){
+	if( pid )
+		return;
+	queue = xQueueCreate( SETUP_NOTIFY_QUEUE, sizeof(t_setup_event) );
+	xTaskCreatePinnedToCore(&notifyTask, "setupNotify", 3072, NULL, 5, &pid, 0);
+}
+
+void SetupNotify::notifyTask( void *pvParameters ){
+	t_setup_event ev;
+	while( true ){
+		if( xQueueReceive( queue, &ev, portMAX_DELAY ) != pdTRUE )
+			continue;
+		portENTER_CRITICAL( &notifyMux );  // attach() and detach() may rewrite the slot meanwhile
+		t_setup_observer o = observers[ev.idx];
+		portEXIT_CRITICAL( &notifyMux );
+		if( o.item != ev.item || o.cb != ev.cb )   // detached, or slot reused, in the meantime
+			continue;
+		(*o.dispatch)( o.cb, o.item, ev.oldval, ev.newval, o.arg );
+		if( _dropped ){
+			ESP_LOGW(FNAME,"%d config notifications dropped, queue full", _dropped );
+			_dropped = 0;
+		}
+	}
+}
@@ -0,0 +1,58 @@
+/*
+ * SetupNotify.h
+ *
+ * Allocation free change notification for SetupNG config items.
+ *
+ * Observers are registered per config item in a fixed size table and get
+ * the old and the new value. They are either called synchronously inside
+ * set(), or deferred: then set() only posts the change into a queue and
+ * the setupNotify task delivers it, so the setter is never blocked by a
+ * slow observer.
+ *
+ *   void baudChanged( SetupNG<int> *item, int oldval, int newval, void *arg );
+ *   serial1_speed.attach( baudChanged, nullptr, true );
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+class SetupCommon;
+
+#define SETUP_MAX_OBSERVERS  16   // size of the observer table
+#define SETUP_NOTIFY_VALSIZE 8    // max. sizeof(T) for deferred delivery
+#define SETUP_NOTIFY_QUEUE   8    // pending deferred notifications
+
+// type erased call into the typed observer, see SetupNG<T>::attach()
+typedef void (*setup_dispatch_t)( void (*cb)(), SetupCommon *item, const void *oldval, const void *newval, void *arg );
+
+typedef struct setup_observer {
+	SetupCommon      *item;
+	setup_dispatch_t dispatch;
+	void             (*cb)();
+	void             *arg;
+	bool             deferred;
+} t_setup_observer;
+
+class SetupNotify {
+public:
+	// returns false if the table is full or the value is too big for deferred delivery
+	static bool attach( SetupCommon *item, setup_dispatch_t dispatch, void (*cb)(), void *arg, bool deferred, size_t valsize );
+	static void detach( SetupCommon *item, void (*cb)() );
+	// called from SetupNG::set(), never blocks
+	static void notify( SetupCommon *item, const void *oldval, const void *newval, size_t valsize );
+	static inline int dropped() { return _dropped; }
+
+private:
+	static void startTask();
+	static void notifyTask( void *pvParameters );
+
+	static t_setup_observer observers[SETUP_MAX_OBSERVERS];
+	static int numObservers;
+	static int _dropped;
+	static QueueHandle_t queue;
+	static TaskHandle_t pid;
+};
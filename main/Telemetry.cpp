@@ -0,0 +1,159 @@
+/*
+ * Telemetry.cpp
+ *
+ * Server sent events with the live device state.
+ */
+
+#include "Telemetry.h"
+#include "Flarm.h"
+#include "Units.h"
+#include "Webserver.h"
+#include "freertos/task.h"
+#include "driver/temp_sensor.h"
+#include <esp_system.h>
+#include <cstdio>
+#include <cstring>
+#include <logdef.h>
+
+httpd_handle_t Telemetry::server = nullptr;
+int Telemetry::clients[TELEMETRY_MAX_CLIENTS] = { -1, -1, -1 };
+int Telemetry::numClients = 0;
+t_telemetry Telemetry::last;
+char Telemetry::msg[TELEMETRY_MSG_LEN];
+int Telemetry::msgLen = 0;
+volatile bool Telemetry::pending = false;
+volatile int Telemetry::strobe = 0;
+TaskHandle_t Telemetry::pid = 0;
+
+void Telemetry::start( httpd_handle_t s ){
+	server = s;
+	sample( last );
+	if( !pid )
+		xTaskCreatePinnedToCore(&task, "telemetry", 3072, NULL, 4, &pid, 0);
+}
+
+void Telemetry::stop(){
+	server = nullptr;
+	numClients = 0;
+	for( int i=0; i<TELEMETRY_MAX_CLIENTS; i++ )
+		clients[i] = -1;
+}
+
+void Telemetry::sample( t_telemetry &t ){
+	float temp = 0;
+	t.gps = Flarm::gpsStatus();
+	t.gs = t.gps ? (int16_t)(Units::knots2kmh( Flarm::getGndSpeedKnots() ) + 0.5) : 0;
+	t.alarm = Flarm::alarmLevel();
+	t.traffic = Flarm::traffic();
+	t.strobe = strobe;
+	if( temp_sensor_read_celsius( &temp ) == ESP_OK )
+		t.temp = (int16_t)(temp + 0.5);
+	t.ota = Webserver.getOtaProgress();
+	t.heap = esp_get_free_heap_size() / 1024;
+}
+
+// SSE event with the fields differing from prev, all if prev is nullptr, 0 if nothing changed
+int Telemetry::format( const t_telemetry &t, const t_telemetry *prev, char *buf, size_t len ){
+	int n = snprintf( buf, len, "data: {" );
+	const char *sep = "";
+#define TELEMETRY_FIELD( f ) \
+	if( !prev || t.f != prev->f ){ \
+		n += snprintf( buf+n, len-n, "%s\"" #f "\":%d", sep, (int)t.f ); \
+		sep = ","; \
+	}
+	TELEMETRY_FIELD( gps )
+	TELEMETRY_FIELD( gs )
+	TELEMETRY_FIELD( alarm )
+	TELEMETRY_FIELD( traffic )
+	TELEMETRY_FIELD( strobe )
+	TELEMETRY_FIELD( temp )
+	TELEMETRY_FIELD( ota )
+	TELEMETRY_FIELD( heap )
+#undef TELEMETRY_FIELD
+	if( !*sep )
+		return 0;
+	n += snprintf( buf+n, len-n, "}\n\n" );
+	return n;
+}
+
+// GET /events, answers the headers and the full state, then keeps the socket
+esp_err_t Telemetry::handler( httpd_req_t *req ){
+	int slot = -1;
+	for( int i=0; i<TELEMETRY_MAX_CLIENTS; i++ ){
+		if( clients[i] < 0 ){
+			slot = i;
+			break;
+		}
+	}
+	if( slot < 0 ){
+		httpd_resp_set_status( req, "503 Service Unavailable" );
+		httpd_resp_send( req, "Too many clients", HTTPD_RESP_USE_STRLEN );
+		return ESP_OK;
+	}
+	char buf[TELEMETRY_MSG_LEN];
+	t_telemetry t = last;
+	int n = snprintf( buf, sizeof(buf), "retry: 2000\n" );
+	n += format( t, nullptr, buf+n, sizeof(buf)-n );
+	httpd_resp_set_type( req, "text/event-stream" );
+	httpd_resp_set_hdr( req, "Cache-Control", "no-cache" );
+	httpd_resp_set_hdr( req, "Access-Control-Allow-Origin", "*" );
+	if( httpd_resp_send_chunk( req, buf, n ) != ESP_OK )
+		return ESP_FAIL;
+	// the response stays open, the socket is written by sendAll() from now on
+	clients[slot] = httpd_req_to_sockfd( req );
+	numClients++;
+	req->sess_ctx = &clients[slot];
+	req->free_ctx = closed;
+	ESP_LOGI(FNAME,"Telemetry client %d connected, socket %d", slot, clients[slot] );
+	return ESP_OK;
+}
+
+// session closed by httpd
+void Telemetry::closed( void *ctx ){
+	int *client = (int*)ctx;
+	if( *client >= 0 ){
+		*client = -1;
+		numClients--;
+	}
+}
+
+// httpd work, runs in the server task, msg is a complete HTTP chunk
+void Telemetry::sendAll( void *arg ){
+	for( int i=0; i<TELEMETRY_MAX_CLIENTS && server; i++ ){
+		if( clients[i] >= 0 && httpd_socket_send( server, clients[i], msg, msgLen, 0 ) < 0 ){
+			ESP_LOGI(FNAME,"Telemetry client %d gone", i );
+			httpd_sess_trigger_close( server, clients[i] );  // calls closed()
+		}
+	}
+	pending = false;
+}
+
+void Telemetry::task( void *pvParameters ){
+	int quiet = 0;  // ms since the last event
+	while( true ){
+		vTaskDelay( TELEMETRY_PERIOD_MS / portTICK_PERIOD_MS );
+		if( !server || !numClients || pending )
+			continue;
+		t_telemetry t = last;  // fields sample() can not read keep their last value
+		sample( t );
+		// leave room for the chunk size line and the chunk end
+		char *event = msg + 6;
+		int n = format( t, &last, event, sizeof(msg) - 8 );
+		quiet += TELEMETRY_PERIOD_MS;
+		if( !n && quiet < TELEMETRY_KEEPALIVE_MS )
+			continue;
+		if( !n )
+			n = snprintf( event, sizeof(msg) - 8, ":\n\n" );
+		quiet = 0;
+		last = t;
+		// one HTTP chunk for all clients: "%04x\r\n" event "\r\n"
+		char size[7];
+		snprintf( size, sizeof(size), "%04x\r\n", n );
+		memcpy( msg, size, 6 );
+		memcpy( event + n, "\r\n", 2 );
+		msgLen = n + 8;
+		pending = true;
+		if( httpd_queue_work( server, sendAll, nullptr ) != ESP_OK )
+			pending = false;
+	}
+}
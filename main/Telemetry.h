@@ -0,0 +1,61 @@
+/*
+ * Telemetry.h
+ *
+ * Live device state as server sent events, GET /events on the live http
+ * server. The state is sampled every TELEMETRY_PERIOD_MS, only changed
+ * fields are sent, formatted once and written to all clients:
+ *
+ *   data: {"gs":87,"temp":41}
+ *
+ * A new client first gets all fields. Sockets are written from within the
+ * httpd task (httpd_queue_work), so they can't be closed meanwhile.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <esp_http_server.h>
+#include "freertos/FreeRTOS.h"
+
+#define TELEMETRY_MAX_CLIENTS  3
+#define TELEMETRY_PERIOD_MS    250      // sample rate, max. 4 events/s
+#define TELEMETRY_KEEPALIVE_MS 15000    // comment line if nothing changed
+#define TELEMETRY_MSG_LEN      256
+
+typedef struct {
+	int8_t  gps;        // GPS fix
+	int16_t gs;         // ground speed km/h
+	int8_t  alarm;      // Flarm alarm level
+	int8_t  traffic;    // Flarm devices received
+	int8_t  strobe;     // flash frequency, e_flash_freq
+	int16_t temp;       // CPU temperature °C
+	int8_t  ota;        // OTA progress %
+	int16_t heap;       // free heap KB
+} t_telemetry;
+
+class Telemetry {
+public:
+	static void start( httpd_handle_t server );
+	static void stop();
+	static esp_err_t handler( httpd_req_t *req );    // GET /events
+	static inline void setStrobe( int freq ) { strobe = freq; }
+	static inline int getStrobe() { return strobe; }
+
+private:
+	static void sample( t_telemetry &t );
+	static int format( const t_telemetry &t, const t_telemetry *prev, char *buf, size_t len );
+	static void task( void *pvParameters );
+	static void sendAll( void *arg );
+	static void closed( void *ctx );
+
+	static httpd_handle_t server;
+	static int clients[TELEMETRY_MAX_CLIENTS];   // socket, -1 if free
+	static int numClients;
+	static t_telemetry last;
+	static char msg[TELEMETRY_MSG_LEN];
+	static int msgLen;
+	static volatile bool pending;               // msg queued, not sent yet
+	static volatile int strobe;
+	static TaskHandle_t pid;
+};
@@ -0,0 +1,84 @@
+/*
+ * Traffic.cpp
+ *
+ * Flarm target table and radar snapshot.
+ */
+
+#include "Traffic.h"
+#include "Telemetry.h"
+#include "Units.h"
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+t_radar_target Traffic::targets[TRAFFIC_MAX_TARGETS];
+int Traffic::num = 0;
+
+static portMUX_TYPE trafficMux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline int16_t sat16( int v ){
+	return (int16_t)std::max( -32768, std::min( 32767, v ) );
+}
+
+void Traffic::update( const nmea_pflaa_s &p ){
+	t_radar_target t;
+	t.id = (p.ID & 0xffffff) | ((p.idType & 3) << 24);
+	t.north = sat16( p.relNorth );
+	t.east = sat16( p.relEast );
+	t.vertical = sat16( p.relVertical );
+	t.track = (uint16_t)(p.track % 360);
+	t.climb = (int8_t)std::max( -127, std::min( 127, (int)(p.climbRate * 10) ) );
+	t.speed = (uint8_t)std::min( 255, (int)p.groundSpeed );
+	t.alarm = (p.alarmLevel & 0x0f) | ((strtol( p.acftType, nullptr, 16 ) & 0x0f) << 4);
+	t.age = 0;
+
+	portENTER_CRITICAL( &trafficMux );
+	int i = 0;
+	while( i < num && targets[i].id != t.id )
+		i++;
+	if( i == TRAFFIC_MAX_TARGETS ){  // full, replace the oldest one
+		i = 0;
+		for( int k=1; k<num; k++ )
+			if( targets[k].age > targets[i].age )
+				i = k;
+	}
+	else if( i == num )
+		num++;
+	targets[i] = t;
+	portEXIT_CRITICAL( &trafficMux );
+}
+
+void Traffic::tick(){
+	portENTER_CRITICAL( &trafficMux );
+	for( int i=0; i<num; ){
+		if( ++targets[i].age > TRAFFIC_TIMEOUT )
+			targets[i] = targets[--num];
+		else
+			i++;
+	}
+	portEXIT_CRITICAL( &trafficMux );
+}
+
+int Traffic::count(){
+	return num;
+}
+
+int Traffic::radar( uint8_t *buf, size_t len ){
+	t_radar_header h;
+	float gs = 0, track = 0;
+	h.version = RADAR_VERSION;
+	h.flags = (Flarm::getSim() ? RADAR_FLAG_SIM : 0);
+	if( Flarm::getGPS( gs, track ) )
+		h.flags |= RADAR_FLAG_GPS;
+	h.strobe = Telemetry::getStrobe();
+	h.track = (uint16_t)track;
+	h.gs = (uint16_t)(gs + 0.5);
+
+	size_t max = (len - sizeof(h)) / sizeof(t_radar_target);
+	portENTER_CRITICAL( &trafficMux );
+	h.count = std::min( (size_t)num, max );
+	memcpy( buf + sizeof(h), targets, h.count * sizeof(t_radar_target) );
+	portEXIT_CRITICAL( &trafficMux );
+	memcpy( buf, &h, sizeof(h) );
+	return sizeof(h) + h.count * sizeof(t_radar_target);
+}
@@ -0,0 +1,56 @@
+/*
+ * Traffic.h
+ *
+ * Table of the Flarm targets currently received via PFLAA, for the radar
+ * web view. Targets are kept by ID and dropped after TRAFFIC_TIMEOUT
+ * Flarm task ticks without update.
+ *
+ * GET /radar.bin answers a t_radar_header followed by count t_radar_target,
+ * all little endian, see radar() and html/index.html.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "Flarm.h"
+
+#define TRAFFIC_MAX_TARGETS  32
+#define TRAFFIC_TIMEOUT      20     // ticks of 250 ms
+
+#define RADAR_VERSION        1
+#define RADAR_FLAG_SIM       0x01   // Flarm simulation running
+#define RADAR_FLAG_GPS       0x02   // own GPS OK
+
+typedef struct __attribute__((packed)) {
+	uint8_t  version;       // RADAR_VERSION
+	uint8_t  count;         // targets following
+	uint8_t  flags;         // RADAR_FLAG_*
+	uint8_t  strobe;        // flash frequency, e_flash_freq
+	uint16_t track;         // own ground track deg
+	uint16_t gs;            // own ground speed km/h
+} t_radar_header;
+
+typedef struct __attribute__((packed)) {
+	uint32_t id;            // bits 0..23 Flarm ID, 24..25 ID type
+	int16_t  north;         // relative position m, saturated
+	int16_t  east;
+	int16_t  vertical;
+	uint16_t track;         // deg
+	int8_t   climb;         // 0.1 m/s, saturated
+	uint8_t  speed;         // m/s
+	uint8_t  alarm;         // bits 0..3 alarm level, 4..7 aircraft type
+	uint8_t  age;           // ticks since the last update
+} t_radar_target;
+
+class Traffic {
+public:
+	static void update( const nmea_pflaa_s &pflaa );   // from the PFLAA parser
+	static void tick();                               // from the Flarm task
+	static int count();
+	static int radar( uint8_t *buf, size_t len );     // snapshot, returns length
+
+private:
+	static t_radar_target targets[TRAFFIC_MAX_TARGETS];
+	static int num;
+};
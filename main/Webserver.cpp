@@ -4,6 +4,15 @@
 #include "Webserver.h"
 #include "logdef.h"
 #include "coredump_to_server.h"
+#include "BootProfile.h"
+#include "OtaWriter.h"
+#include "OtaDecoder.h"
+#include "Telemetry.h"
+#include "Traffic.h"
+#include "Gzip.h"
+#include "Flarm.h"
+#include <esp_rom_crc.h>
+#include <mbedtls/sha256.h>
 
 cWebserver* cWebserver::m_instance = nullptr;
 extern char * program_version;
@@ -20,16 +29,22 @@ extern const uint8_t milligram_min_css_start[]      asm("_binary_milligram_min_c
 extern const uint8_t milligram_min_css_end[]        asm("_binary_milligram_min_css_end");
 extern const uint8_t milligram_min_css_gz_start[]   asm("_binary_milligram_min_css_gz_start");
 extern const uint8_t milligram_min_css_gz_end[]     asm("_binary_milligram_min_css_gz_end");
+extern const char    index_html_etag[]              asm("_binary_index_html_etag_start");
+extern const char    milligram_min_css_etag[]       asm("_binary_milligram_min_css_etag_start");
 
 // http handlers
 static esp_err_t GET_index_html_handler(httpd_req_t *req);
 static esp_err_t GET_milligram_min_css_handler(httpd_req_t *req);
 static esp_err_t GET_status_json_handler(httpd_req_t *req);
+static esp_err_t GET_update_handler(httpd_req_t *req);
 static esp_err_t POST_update_handler(httpd_req_t *req);
 static esp_err_t GET_backup_handler(httpd_req_t *req);
 static esp_err_t POST_restore_handler(httpd_req_t *req);
 static esp_err_t DELETE_reset_handler(httpd_req_t *req);
 static esp_err_t GET_coredump_handler(httpd_req_t *req);
+static esp_err_t GET_coredump_bin_handler(httpd_req_t *req);
+static esp_err_t GET_radar_bin_handler(httpd_req_t *req);
+static esp_err_t POST_sim_handler(httpd_req_t *req);
 
 httpd_uri_t GET_index_html = {
 	.uri = "/",
@@ -52,6 +67,13 @@ httpd_uri_t GET_stats_json = {
 	.user_ctx = NULL
 };
 
+httpd_uri_t GET_update = {
+	.uri = "/update",
+	.method = HTTP_GET,
+	.handler = GET_update_handler,
+	.user_ctx = NULL
+};
+
 httpd_uri_t POST_update = {
 	.uri = "/update",
 	.method = HTTP_POST,
@@ -59,6 +81,34 @@ httpd_uri_t POST_update = {
 	.user_ctx = NULL
 };
 
+httpd_uri_t GET_events = {
+	.uri = "/events",
+	.method = HTTP_GET,
+	.handler = Telemetry::handler,
+	.user_ctx = NULL
+};
+
+httpd_uri_t GET_coredump_bin = {
+	.uri = "/coredump.bin",
+	.method = HTTP_GET,
+	.handler = GET_coredump_bin_handler,
+	.user_ctx = NULL
+};
+
+httpd_uri_t GET_radar_bin = {
+	.uri = "/radar.bin",
+	.method = HTTP_GET,
+	.handler = GET_radar_bin_handler,
+	.user_ctx = NULL
+};
+
+httpd_uri_t POST_sim = {
+	.uri = "/sim",
+	.method = HTTP_POST,
+	.handler = POST_sim_handler,
+	.user_ctx = NULL
+};
+
 httpd_uri_t GET_backup = {
 	.uri = "/backup",
 	.method = HTTP_GET,
@@ -119,7 +169,9 @@ void cWebserver::start()
 		
 	// Lets bump up the stack size (default was 4096)
 	config.stack_size = 8192;
-	config.max_uri_handlers = 10;
+	config.max_uri_handlers = 16;
+	config.max_open_sockets = 5;
+	config.lru_purge_enable = true;
 	
 	// Start the httpd server
 	ESP_LOGI(FNAME, "Starting http server on port: '%d'", config.server_port);
@@ -131,20 +183,52 @@ void cWebserver::start()
 		httpd_register_uri_handler(m_httpHandle, &GET_index_html);
 		httpd_register_uri_handler(m_httpHandle, &GET_milligram_min_css);
 		httpd_register_uri_handler(m_httpHandle, &GET_stats_json);
+		httpd_register_uri_handler(m_httpHandle, &GET_update);
 		httpd_register_uri_handler(m_httpHandle, &POST_update);
 		httpd_register_uri_handler(m_httpHandle, &GET_backup);
 		httpd_register_uri_handler(m_httpHandle, &POST_restore);
 		httpd_register_uri_handler(m_httpHandle, &DELETE_reset);
 	    httpd_register_uri_handler(m_httpHandle, &GET_coredump);
+	    httpd_register_uri_handler(m_httpHandle, &GET_coredump_bin);
 	}
     else
     {
 	    ESP_LOGE(FNAME, "Error starting http server!");
     }
+
+	// Second server with its own task for the small, frequent requests. Every
+	// httpd instance runs its handlers one after the other, so status polling
+	// must not wait behind a long /update or /coredump transfer on port 80.
+	httpd_config_t live = HTTPD_DEFAULT_CONFIG();
+	live.server_port = WEBSERVER_LIVE_PORT;
+	live.ctrl_port = config.ctrl_port + 1;
+	live.stack_size = 4096;
+	live.task_priority = config.task_priority + 1;
+	live.max_uri_handlers = 8;
+	live.max_open_sockets = TELEMETRY_MAX_CLIENTS + 2;
+	live.lru_purge_enable = true;
+
+	ESP_LOGI(FNAME, "Starting live http server on port: '%d'", live.server_port);
+	if (httpd_start(&m_liveHandle, &live) == ESP_OK)
+	{
+		httpd_register_uri_handler(m_liveHandle, &GET_stats_json);
+		httpd_register_uri_handler(m_liveHandle, &GET_update);
+		httpd_register_uri_handler(m_liveHandle, &GET_events);
+		httpd_register_uri_handler(m_liveHandle, &GET_radar_bin);
+		httpd_register_uri_handler(m_liveHandle, &POST_sim);
+		Telemetry::start(m_liveHandle);
+	}
+	else
+	{
+	    ESP_LOGE(FNAME, "Error starting live http server!");
+	}
 }
 
 void cWebserver::stop()
 {
+    Telemetry::stop();
+    httpd_stop(m_liveHandle);
+    m_liveHandle = nullptr;
     httpd_stop(m_httpHandle);
     m_httpHandle = nullptr;
 }
@@ -154,38 +238,46 @@ void cWebserver::stop()
  * 
  */
 
-// GET /index.html
+// Embedded asset with ETag, answered with 304 if the browser still has it.
+// cache is the Cache-Control value, see html/build_assets.py for the ETags.
+static esp_err_t send_asset(httpd_req_t *req, const char *type, const uint8_t *start, const uint8_t *end, const char *etag, const char *cache)
+{
+	char match[64];
+	httpd_resp_set_hdr(req, "ETag", etag);
+	httpd_resp_set_hdr(req, "Cache-Control", cache);
+	if( httpd_req_get_hdr_value_str(req, "If-None-Match", match, sizeof(match)) == ESP_OK && strstr(match, etag) ){
+		httpd_resp_set_status(req, "304 Not Modified");
+		return httpd_resp_send(req, nullptr, 0);
+	}
+	httpd_resp_set_type(req, type);
+#if CONFIG_WEBSERVER_USE_GZIP
+	httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+#endif
+	return httpd_resp_send(req, (const char *)start, end - start);
+}
+
+// GET /index.html, revalidated on every visit: the URL stays the same after an update
 static esp_err_t GET_index_html_handler(httpd_req_t *req)
 {
 	ESP_LOGI(FNAME, "index.html Requested");
 
-	httpd_resp_set_type(req, "text/html");
-
 #if CONFIG_WEBSERVER_USE_GZIP
-    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
-	httpd_resp_send(req, (const char *)index_html_gz_start, index_html_gz_end - index_html_gz_start);
+	return send_asset(req, "text/html", index_html_gz_start, index_html_gz_end, index_html_etag, "no-cache");
 #else
-	httpd_resp_send(req, (const char *)index_html_start, index_html_end - index_html_start);
+	return send_asset(req, "text/html", index_html_start, index_html_end, index_html_etag, "no-cache");
 #endif
-
-	return ESP_OK;
 }
 
-// GET /milligram.min.css
+// GET /milligram.min.css, referenced as ?v=<etag>, so it never changes under its URL
 static esp_err_t GET_milligram_min_css_handler(httpd_req_t *req)
 {
 	ESP_LOGI(FNAME, "milligram.min.css Requested");
 
-	httpd_resp_set_type(req, "text/css");
-
-#if CONFIG_WEBSERVER_USE_GZIP 
-    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
-	httpd_resp_send(req, (const char *)milligram_min_css_gz_start, milligram_min_css_gz_end - milligram_min_css_gz_start);
+#if CONFIG_WEBSERVER_USE_GZIP
+	return send_asset(req, "text/css", milligram_min_css_gz_start, milligram_min_css_gz_end, milligram_min_css_etag, "public, max-age=31536000, immutable");
 #else
-	httpd_resp_send(req, (const char *)milligram_min_css_start, milligram_min_css_end - milligram_min_css_start);
+	return send_asset(req, "text/css", milligram_min_css_start, milligram_min_css_end, milligram_min_css_etag, "public, max-age=31536000, immutable");
 #endif
-
-	return ESP_OK;
 }
 
 // GET /status.json
@@ -193,131 +285,241 @@ static esp_err_t GET_status_json_handler(httpd_req_t *req)
 {
   	ESP_LOGI(FNAME, "status.json Requested");
 
-	char jsonBuffer[200];
-    const char json[] = R"({"compile_time":"%s","compile_date":"%s","program_version":"%s","ota_status":"%d","coredump_available":"%d"})";
+	char jsonBuffer[640];
+	char boot[256];
+	char running[65] = "";
+    const char json[] = R"({"compile_time":"%s","compile_date":"%s","program_version":"%s","ota_status":"%d","coredump_available":"%d","running_sha256":"%s","boot_ms":%s})";
 
-	snprintf(jsonBuffer, 199, json, __TIME__, __DATE__, program_version, 0, coredump_available());
+	if( BootProfile::json(boot, sizeof(boot)) < 0 )
+		strcpy(boot, "{}");
+	// delta updates are made against this image
+	const uint8_t *sha = OtaDecoder::runningSha256();
+	for( int i=0; sha && i<32; i++ )
+		sprintf(&running[2*i], "%02x", sha[i]);
+	snprintf(jsonBuffer, sizeof(jsonBuffer), json, __TIME__, __DATE__, program_version, 0, coredump_available(), running, boot);
 
 	httpd_resp_set_type(req, "application/json ");
+	httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");  // page is served by port 80
 	httpd_resp_send(req, jsonBuffer, strlen(jsonBuffer));
 
 	return ESP_OK;
 }
 
-bool otaStarted = false;
-char *otaBuffer = nullptr;
-const esp_partition_t *otaUpdatePartition;
-esp_ota_handle_t otaHandle = {0};
+// GET /radar.bin, snapshot of the Flarm traffic table, polled by the radar view
+static esp_err_t GET_radar_bin_handler(httpd_req_t *req)
+{
+	uint8_t buf[sizeof(t_radar_header) + TRAFFIC_MAX_TARGETS*sizeof(t_radar_target)];
+	int len = Traffic::radar(buf, sizeof(buf));
+
+	httpd_resp_set_type(req, "application/octet-stream");
+	httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+	httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+	return httpd_resp_send(req, (const char *)buf, len);
+}
+
+// POST /sim, replay the built in Flarm traffic scenario
+static esp_err_t POST_sim_handler(httpd_req_t *req)
+{
+	ESP_LOGI(FNAME, "Flarm simulation requested");
+	Flarm::startSim();
+	httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+	return httpd_resp_send(req, "Okay", 4);
+}
+
 size_t otaSize = 0;
-size_t otaReceived = 0;
+uint32_t otaImage = 0;   // CRC32 of the whole image, identifies the upload
 
-// Receive .Bin file
-static esp_err_t POST_update_handler(httpd_req_t *req)
+// unsigned header value, false if missing or not a number
+static bool get_hdr_uint(httpd_req_t *req, const char *field, uint32_t &val, int base)
+{
+    char buf[16];
+    if (httpd_req_get_hdr_value_str(req, field, buf, sizeof(buf)) != ESP_OK)
+    {
+        return false;
+    }
+    char *end;
+    val = strtoul(buf, &end, base);
+    return end != buf && *end == 0;
+}
+
+// Reply with the number of bytes received in sequence, the client continues from there
+static esp_err_t send_ota_state(httpd_req_t *req, const char *status, const char *msg)
 {
-    size_t ota_buff_size = 16 * 1024;
+    char json[128];
+    snprintf(json, sizeof(json), R"({"offset":%u,"size":%u,"image":"%x","active":%d,"msg":"%s"})",
+        OtaWriter::active() ? OtaWriter::submitted() : 0, otaSize, otaImage, OtaWriter::active(), msg);
+    httpd_resp_set_status(req, status);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+    return httpd_resp_send(req, json, strlen(json));
+}
+
+// GET /update, resume point of an interrupted upload
+static esp_err_t GET_update_handler(httpd_req_t *req)
+{
+    const char *msg = "idle";
+    if (Webserver.getOtaStatus() == otaStatus::DONE)
+        msg = "done";
+    else if (Webserver.getOtaStatus() == otaStatus::ERROR)
+        msg = "error";
+    else if (OtaWriter::active())
+        msg = "active";
+    return send_ota_state(req, "200 OK", msg);
+}
 
+// Receive one .Bin file chunk, flash writes run in the OtaWriter task meanwhile
+//
+// X-OTA-SIZE    total image size
+// X-OTA-IMAGE   CRC32 of the whole image (hex), a different one starts a new upload
+// X-OTA-OFFSET  position of this chunk in the image
+// X-OTA-CRC     CRC32 of this chunk (hex)
+//
+// A chunk is only written after its CRC matched. Chunks already received are
+// acknowledged again without writing, so a chunk whose reply got lost can
+// just be sent again.
+static esp_err_t POST_update_handler(httpd_req_t *req)
+{
     size_t content_length = req->content_len;
-    int content_received = 0;
+    uint32_t size = 0, image = 0, offset = 0, crc = 0;
     int recv_len;
 
-    if (content_length < 1)
+    get_hdr_uint(req, "X-OTA-SIZE", size, 10);
+    get_hdr_uint(req, "X-OTA-IMAGE", image, 16);
+    bool hasOffset = get_hdr_uint(req, "X-OTA-OFFSET", offset, 10);
+    bool hasCrc = get_hdr_uint(req, "X-OTA-CRC", crc, 16);
+
+    if (content_length < 1 || content_length > OTA_CHUNK_MAX || size == 0)
     {
-        return ESP_OK;
+        return send_ota_state(req, "400 Bad Request", "bad chunk");
     }
 
-    // Received first chunk - start OTA procedure
-    if (!otaStarted)
+    // Other image or nothing started yet - start OTA procedure
+    if (!OtaWriter::active() || size != otaSize || image != otaImage)
     {
-        otaStarted = true;
-        otaBuffer = (char*)malloc(ota_buff_size);
-
-        // Get total OTA file size
-        size_t buf_len = httpd_req_get_hdr_value_len(req, "X-OTA-SIZE") + 1;
-        if (buf_len > 1)
+        // A stray chunk of another upload leaves the active one alone
+        if (hasOffset && offset != 0)
         {
-            char otaSizeBuffer[32];
-            if (httpd_req_get_hdr_value_str(req, "X-OTA-SIZE", otaSizeBuffer, sizeof(otaSizeBuffer)) == ESP_OK)
-            {
-                otaSize = atoi(otaSizeBuffer);
-                ESP_LOGI(FNAME, "Found header => X-OTA-SIZE: %s", otaSizeBuffer);
-            }
+            return send_ota_state(req, "409 Conflict", "unknown upload");
         }
-
-        otaUpdatePartition = esp_ota_get_next_update_partition(NULL);
-
-        esp_err_t err = esp_ota_begin(otaUpdatePartition, otaSize, &otaHandle);
+        ESP_LOGI(FNAME, "New upload, size %u image %08x", size, image);
+        otaSize = size;
+        otaImage = image;
+        Webserver.setOtaStatus(otaStatus::IDLE);
+        esp_err_t err = OtaWriter::begin(otaSize);
         if (err != ESP_OK)
         {
-            ESP_LOGE(FNAME, "Error With OTA Begin, Cancelling OTA");
-            return ESP_FAIL;
-        }
-        else
-        {
-            ESP_LOGI(FNAME, "Writing to partition subtype %d at offset 0x%x", otaUpdatePartition->subtype, otaUpdatePartition->address);
+            ESP_LOGE(FNAME, "Error With OTA Begin: %s, Cancelling OTA", esp_err_to_name(err));
+            Webserver.setOtaStatus(otaStatus::ERROR);
+            return send_ota_state(req, "500 Internal Server Error", "begin failed");
         }
     }
 
-    do
+    size_t committed = OtaWriter::submitted();
+    if (!hasOffset)
+    {
+        offset = committed;
+    }
+    if (offset > committed)
+    {
+        ESP_LOGW(FNAME, "Chunk at %u, expected %u", offset, committed);
+        return send_ota_state(req, "409 Conflict", "out of order");
+    }
+    if (offset + content_length > otaSize)
     {
-        // Read the ota data
-        if ((recv_len = httpd_req_recv(req, otaBuffer, std::min(content_length, ota_buff_size))) < 0)
+        ESP_LOGW(FNAME, "Chunk at %u length %u exceeds size %u", offset, content_length, otaSize);
+        return send_ota_state(req, "400 Bad Request", "bad chunk");
+    }
+
+    // Receive the whole chunk into pipeline buffers, nothing is written yet
+    char *bufs[OTA_CHUNK_MAX / OTA_BUF_SIZE];
+    size_t lens[OTA_CHUNK_MAX / OTA_BUF_SIZE];
+    int nbufs = 0;
+    size_t content_received = 0;
+    uint32_t crc_calc = 0;
+    while (content_received < content_length)
+    {
+        char *buf = OtaWriter::getBuffer();
+        size_t fill = 0;
+        size_t want = std::min(content_length - content_received, (size_t)OTA_BUF_SIZE);
+        while (fill < want)
         {
-            if (recv_len == HTTPD_SOCK_ERR_TIMEOUT)
+            if ((recv_len = httpd_req_recv(req, buf + fill, want - fill)) <= 0)
             {
-                ESP_LOGW(FNAME, "Socket Timeout");
-                /* Retry receiving if timeout occurred */
-                continue;
+                if (recv_len == HTTPD_SOCK_ERR_TIMEOUT)
+                {
+                    ESP_LOGW(FNAME, "Socket Timeout");
+                    /* Retry receiving if timeout occurred */
+                    continue;
+                }
+                // Connection lost, the client sends this chunk again
+                ESP_LOGE(FNAME, "OTA Other Error %d", recv_len);
+                OtaWriter::release(buf);
+                while (nbufs)
+                    OtaWriter::release(bufs[--nbufs]);
+                return ESP_FAIL;
             }
-            ESP_LOGE(FNAME, "OTA Other Error %d", recv_len);
-            return ESP_FAIL;
+            fill += recv_len;
         }
+        crc_calc = esp_rom_crc32_le(crc_calc, (const uint8_t *)buf, fill);
+        bufs[nbufs] = buf;
+        lens[nbufs++] = fill;
+        content_received += fill;
+    }
 
-        // Write OTA data
-        esp_ota_write(otaHandle, otaBuffer, recv_len);
-        content_received += recv_len;
-        otaReceived += recv_len;
-
-    } while (recv_len > 0 && content_received < content_length);
-
-    Webserver.setOtaProgress((otaReceived * 100.0f) / otaSize); 
-    ESP_LOGI(FNAME, "Received %d / %d (%.02f)", otaReceived, otaSize, (otaReceived * 100.0) / otaSize);
-
-    if (otaReceived >= otaSize)
+    if (hasCrc && crc_calc != crc)
     {
-        free(otaBuffer);
-        otaStarted = false;
-        // End response
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_send(req, "OK", strlen("OK"));
+        ESP_LOGW(FNAME, "Chunk at %u CRC %08x, expected %08x", offset, crc_calc, crc);
+        for (int i = 0; i < nbufs; i++)
+            OtaWriter::release(bufs[i]);
+        return send_ota_state(req, "400 Bad Request", "crc mismatch");
+    }
 
-        if (esp_ota_end(otaHandle) == ESP_OK)
+    // Write only what is new, a chunk sent again is just acknowledged
+    size_t skip = committed - offset;
+    for (int i = 0; i < nbufs; i++)
+    {
+        if (skip >= lens[i])
         {
-            // Lets update the partition
-            if (esp_ota_set_boot_partition(otaUpdatePartition) == ESP_OK)
-            {
-                const esp_partition_t *boot_partition = esp_ota_get_boot_partition();
-
-                ESP_LOGI(FNAME, "Next boot partition subtype %d at offset 0x%x", boot_partition->subtype, boot_partition->address);
-                ESP_LOGI(FNAME, "Rebooting in 3 seconds...");
-                
-                Webserver.setOtaStatus(otaStatus::DONE);
-            }
-            else
-            {
-                ESP_LOGE(FNAME, "\r\n\r\n !!! Flashed Error !!!\r\n");
-            }
+            OtaWriter::release(bufs[i]);
+            skip -= lens[i];
         }
         else
         {
-            ESP_LOGE(FNAME, "\r\n\r\n !!! OTA End Error !!!\r\n");
+            OtaWriter::submit(bufs[i], lens[i], skip);
+            skip = 0;
         }
     }
-    else
+
+    if (OtaWriter::error() != ESP_OK)
+    {
+        OtaWriter::abort();
+        Webserver.setOtaStatus(otaStatus::ERROR);
+        return send_ota_state(req, "500 Internal Server Error", "write failed");
+    }
+
+    size_t otaReceived = OtaWriter::submitted();
+    Webserver.setOtaProgress((otaReceived * 100.0f) / otaSize);
+    ESP_LOGI(FNAME, "Received %d / %d", otaReceived, otaSize);
+
+    if (otaReceived < otaSize)
+    {
+        return send_ota_state(req, "200 OK", "active");
+    }
+
+    esp_err_t err = OtaWriter::end();
+    if (err != ESP_OK)
     {
-        httpd_resp_send(req, NULL, 0);
+        ESP_LOGE(FNAME, "\r\n\r\n !!! OTA End Error %s !!!\r\n", esp_err_to_name(err));
+        Webserver.setOtaStatus(otaStatus::ERROR);
+        return send_ota_state(req, "500 Internal Server Error", "image invalid");
     }
 
-    return ESP_OK;
+    const esp_partition_t *boot_partition = esp_ota_get_boot_partition();
+    ESP_LOGI(FNAME, "Next boot partition subtype %d at offset 0x%x", boot_partition->subtype, boot_partition->address);
+    ESP_LOGI(FNAME, "Rebooting in 3 seconds...");
+
+    Webserver.setOtaStatus(otaStatus::DONE);
+    return send_ota_state(req, "200 OK", "done");
 }
 
 static esp_err_t GET_backup_handler(httpd_req_t *req)
@@ -377,53 +579,119 @@ static esp_err_t DELETE_reset_handler(httpd_req_t *req)
 	return ESP_OK;
 }
 
+#define COREDUMP_TEXT_LEN (COREDUMP_CHUNK_LEN / COREDUMP_LINE_LEN * (COREDUMP_LINE_LEN / 3 * 4 + 2))
+
+typedef struct {
+	httpd_req_t *req;
+	Gzip        *gz;     // nullptr sends plain text
+	uint8_t     *buf;    // compressed output, Gzip::bound( COREDUMP_TEXT_LEN )
+} t_coredump_ctx;
+
+// one chunked send per piece of text, compressed if the client accepts gzip
+static esp_err_t coredump_send(t_coredump_ctx *ctx, const char *str, size_t len)
+{
+	if( !ctx->gz )
+		return httpd_resp_send_chunk(ctx->req, str, len);
+	size_t n = ctx->gz->compress((const uint8_t *)str, len, ctx->buf);
+	return httpd_resp_send_chunk(ctx->req, (const char *)ctx->buf, n);
+}
+
 static esp_err_t _coredump_to_server_begin_cb_OTA(void * priv)
 {
-	char ver[128];
-	sprintf( ver, "Software Version: %s\r\n", program_version );
-	httpd_resp_send_chunk((httpd_req*)priv, ver, strlen( ver ) );
-	const char *head="================= CORE DUMP START =================\r\n";
-	httpd_resp_send_chunk((httpd_req*)priv, head, strlen( head ) );
-    return ESP_OK;
+	char head[160];
+	int len = snprintf( head, sizeof(head), "Software Version: %s\r\n================= CORE DUMP START =================\r\n", program_version );
+	return coredump_send((t_coredump_ctx *)priv, head, std::min(len, (int)sizeof(head)-1));
 }
 
 static esp_err_t _coredump_to_server_end_cb_OTA(void * priv)
 {
+	t_coredump_ctx *ctx = (t_coredump_ctx *)priv;
 	const char *end="================= CORE DUMP END =================\r\n";
-	httpd_resp_send_chunk((httpd_req*)priv, end, strlen( end ) );
-	httpd_resp_send_chunk((httpd_req*)priv, end, 0 );
-	return ESP_OK;
+	coredump_send(ctx, end, strlen( end ) );
+	if( ctx->gz ){
+		size_t n = ctx->gz->finish(ctx->buf);
+		httpd_resp_send_chunk(ctx->req, (const char *)ctx->buf, n);
+	}
+	return httpd_resp_send_chunk(ctx->req, end, 0 );
 }
 
 static esp_err_t _coredump_to_server_write_cb_OTA(void * priv, char const * const str)
 {
-	ESP_LOGI("OTA", "coredump_to_server_write_cb, size %d bytes; %s", strlen( str ), str );
-	httpd_resp_send_chunk((httpd_req*)priv, str, strlen( str ) );
-	httpd_resp_send_chunk((httpd_req*)priv, "\r\n", 2 );
-	vTaskDelay(50 / portTICK_PERIOD_MS);
-    return ESP_OK;
+	return coredump_send((t_coredump_ctx *)priv, str, strlen( str ));
+}
+
+// true if the request allows a gzip coded response
+static bool accepts_gzip(httpd_req_t *req)
+{
+	char enc[64];
+	if( httpd_req_get_hdr_value_str(req, "Accept-Encoding", enc, sizeof(enc)) != ESP_OK )
+		return false;
+	return strstr(enc, "gzip") != nullptr;
+}
+
+// true if the whole dump went out
+static bool send_coredump( httpd_req *req ) {
+	t_coredump_ctx ctx = { req, nullptr, nullptr };
+	Gzip gz;
+	bool available = coredump_available();
+	if( available && accepts_gzip(req) ){
+		ctx.buf = (uint8_t *)malloc(Gzip::bound(COREDUMP_TEXT_LEN));
+		if( ctx.buf && gz.begin() ){
+			ctx.gz = &gz;
+			httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+		}
+	}
+	coredump_to_server_config_t coredump_cfg = {
+		.start = _coredump_to_server_begin_cb_OTA,
+		.end = _coredump_to_server_end_cb_OTA,
+		.write = _coredump_to_server_write_cb_OTA,
+		.priv = &ctx,
+		.chunk_len = COREDUMP_CHUNK_LEN,
+	};
+	esp_err_t err = coredump_to_server(&coredump_cfg); // Dump to Webserver
+	if( !available ){
+		httpd_resp_send(req, "", 0 );
+	}
+	free(ctx.buf);
+	return err == ESP_OK;
 }
 
-static void send_coredump( httpd_req *req ) {
-	 coredump_to_server_config_t coredump_cfg = {
-	        .start = _coredump_to_server_begin_cb_OTA,
-	        .end = _coredump_to_server_end_cb_OTA,
-	        .write = _coredump_to_server_write_cb_OTA,
-	        .priv = req,
-	    };
-	 ESP_LOGI("OTA", "priv %08x", (unsigned int)req );
-	 if( coredump_to_server(&coredump_cfg) != ESP_OK ){ // Dump to Webserver
-		 httpd_resp_send(req, "", 0 );
-	 }
+// GET /coredump.bin, the raw dump as stored in flash, sent straight from
+// the mapped partition, for tools/coredump_fetch.py and espcoredump.py
+static esp_err_t GET_coredump_bin_handler(httpd_req_t *req)
+{
+	const void *dump;
+	size_t size;
+	spi_flash_mmap_handle_t handle;
+	if( coredump_mmap(&dump, &size, &handle) != ESP_OK ){
+		httpd_resp_set_status(req, "404 Not Found");
+		return httpd_resp_send(req, "No coredump", HTTPD_RESP_USE_STRLEN);
+	}
+	ESP_LOGI(FNAME, "Binary coredump requested, %d bytes", size);
+
+	uint8_t sha[32];
+	char hex[65];
+	mbedtls_sha256_ret((const unsigned char *)dump, size, sha, 0);
+	for( int i=0; i<32; i++ )
+		sprintf(&hex[2*i], "%02x", sha[i]);
+	char disposition[64];
+	snprintf(disposition, sizeof(disposition), "attachment; filename=\"xcflash-core-%s.bin\"", program_version);
+
+	httpd_resp_set_type(req, "application/octet-stream");
+	httpd_resp_set_hdr(req, "Content-Disposition", disposition);
+	httpd_resp_set_hdr(req, "X-Coredump-SHA256", hex);
+	httpd_resp_set_hdr(req, "X-Program-Version", program_version);
+	esp_err_t err = httpd_resp_send(req, (const char *)dump, size);  // sets Content-Length
+	coredump_unmap(handle);
+	return err;
 }
 
 static esp_err_t GET_coredump_handler(httpd_req_t *req)
 {
     ESP_LOGI(FNAME, "Get Core File Requested");
 
-	httpd_resp_set_type(req, "text/html");
-	send_coredump( req );
-
-	clear_coredump();
+	httpd_resp_set_type(req, "text/plain");
+	if( send_coredump( req ) )
+		clear_coredump();  // keep it for another try if the download broke
 	return ESP_OK;
 }
@@ -1,5 +1,8 @@
 #include <esp_http_server.h>
 
+// status and live data, served by an own httpd task next to port 80
+#define WEBSERVER_LIVE_PORT 81
+
 
     enum class otaStatus : int8_t
     {
@@ -31,6 +34,7 @@ private:
     static cWebserver* m_instance;
 
     httpd_handle_t m_httpHandle= nullptr;
+    httpd_handle_t m_liveHandle= nullptr;
     otaStatus m_otaStatus = otaStatus::IDLE;
     int m_otaProgress = 0;
 };
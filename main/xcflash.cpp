@@ -24,6 +24,8 @@
 #include "Colors.h"
 #include "Switch.h"
 #include "driver/temp_sensor.h"
+#include "BootProfile.h"
+#include "Telemetry.h"
 
 OTA *ota = 0;
 AdaptUGC *egl = 0;
@@ -90,11 +92,25 @@ void led_off_gn(){
 #define PERIOD 50
 #define FLASHES (1000/(PERIOD))  // 10
 
+// result of the serial loop test, reported from the serial task
+static void selfTestDone( bool passed )
+{
+    if( passed )
+    	printf("Serial Loop Test OK");
+    else
+    	printf("Self Loop Test Failed");
+    BootProfile::mark( "selftest" );
+    BootProfile::log();
+}
+
 extern "C" void app_main(void)
 {
+    BootProfile::mark( "app_main" );
     initArduino();
+    BootProfile::mark( "arduino" );
     bool setupPresent;
     SetupCommon::initSetup( setupPresent );
+    BootProfile::mark( "setup" );
     printf("Setup present: %d speed: %d\n", setupPresent, serial1_speed.get() );
 
     /* Print chip information */
@@ -120,7 +136,8 @@ extern "C" void app_main(void)
 
     printf("Minimum free heap size: %" PRIu32 " bytes\n", esp_get_minimum_free_heap_size());
 
-    delay(100);
+    if( !fast_start.get() )
+        delay(100);
     //  serial1_speed.set( 1 );  // test for autoBaud
 
     temp_sensor_config_t temp_sensor = TSENS_CONFIG_DEFAULT();
@@ -130,6 +147,7 @@ extern "C" void app_main(void)
     float tsens_out;
     ESP_ERROR_CHECK(temp_sensor_read_celsius(&tsens_out));
     ESP_LOGI(FNAME, "Temperature in %f °C", tsens_out);
+    BootProfile::mark( "tsens" );
 
     Version V;
     std::string ver( "SW Ver.: " );
@@ -146,21 +164,24 @@ extern "C" void app_main(void)
     gpio_pad_select_gpio(GPIO_NUM_9);
     gpio_set_direction(GPIO_NUM_9, GPIO_MODE_OUTPUT);
 
-    // Initial function test
-    for( int i=0; i<3; i++ ){
-    	led_on();
-     	delay( 50 );
-     	led_off();
-     	delay( 50 );
+    // Initial function test, on fast start the first flash burst of the main loop does that job
+    if( !fast_start.get() ){
+    	for( int i=0; i<3; i++ ){
+    		led_on();
+    		delay( 50 );
+    		led_off();
+    		delay( 50 );
+    	}
+    	BootProfile::mark( "ledtest" );
     }
     Switch::startTask();
     Flarm::begin();
     Serial::begin();
+    BootProfile::mark( "serial" );
 
-    if( Serial::selfTest() )
-    	printf("Serial Loop Test OK");
-    else
-    	printf("Self Loop Test Failed");
+    Serial::selfTest( selfTestDone );  // runs along with normal reception
+    BootProfile::mark( "strobe" );
+    BootProfile::log();
 
     int i=0;
     while(1){
@@ -209,6 +230,7 @@ extern "C" void app_main(void)
     		ESP_ERROR_CHECK(temp_sensor_read_celsius(&tsens_out));
     		ESP_LOGI(FNAME,"FREQ: %d, CPU-T: %.2f°C, GPS: %d, GS: %.2f, FlarmAlarm:%d, CloseTarg: %d", flash_freq, tsens_out, Flarm::gpsStatus(), GS, Flarm::alarmLevel(), Flarm::objectInRange( 1.5 ) );
     	}
+    	Telemetry::setStrobe( flash_freq );
     	if( flash_freq == FLASH_OFF ){
     		led_off();
     	}else{
@@ -241,6 +263,7 @@ extern "C" void app_main(void)
     	if( swMode.isClosed() ){
     		ota = new OTA();
     		led_off();
+    		Telemetry::setStrobe( FLASH_OFF );
     		ota->doSoftwareUpdate();
     		while(1){
     			delay(1000);
@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+#
+# Fetches the raw coredump from the device (GET /coredump.bin), checks it
+# against the X-Coredump-SHA256 header, looks up the matching firmware ELF
+# and runs espcoredump.py on the pair.
+#
+#   tools/coredump_fetch.py                           # device AP at 192.168.4.1, ELF from build/
+#   XCFLASH_HOST=10.0.0.7 idf.py coredump-fetch
+#   tools/coredump_fetch.py 10.0.0.7 --elf-dir ~/xcflash-elfs
+#
+# ELF candidates are matched by program_version (main/Version.cpp, derived
+# from the build time in the app descriptor) and confirmed by the ELF
+# SHA-256 prefix the IDF stores in the dump, which wins if the two disagree.
+#
+
+import argparse
+import glob
+import hashlib
+import os
+import re
+import struct
+import subprocess
+import sys
+import urllib.request
+from datetime import datetime
+
+APP_DESC_MAGIC = 0xABCD5432
+CORE_INFO_NOTE = b"ESP_CORE_DUMP_INFO\x00"
+
+
+def fetch(host, timeout=30):
+    with urllib.request.urlopen(f"http://{host}/coredump.bin", timeout=timeout) as r:
+        return r.read(), r.headers.get("X-Coredump-SHA256"), r.headers.get("X-Program-Version")
+
+
+def dump_elf_sha(dump):
+    """Hex prefix of the crashed app's ELF SHA-256, from the core info note, or None."""
+    i = dump.find(CORE_INFO_NOTE)
+    if i < 0:
+        return None
+    desc = dump[i + (len(CORE_INFO_NOTE) + 3) // 4 * 4 + 4:]   # name padded to 4, then version
+    m = re.match(rb"[0-9a-f]+", desc[:64])
+    return m.group(0).decode() if m else None
+
+
+def elf_app_desc(path):
+    """(date, time) strings of the esp_app_desc_t in an ELF, or None."""
+    with open(path, "rb") as f:
+        data = f.read()
+    i = data.find(struct.pack("<I", APP_DESC_MAGIC))
+    while i >= 0:
+        # magic, secure_version, reserv1[2], version[32], project_name[32], time[16], date[16]
+        t = data[i + 80:i + 96].split(b"\0")[0].decode(errors="replace")
+        d = data[i + 96:i + 112].split(b"\0")[0].decode(errors="replace")
+        if re.match(r"\d\d:\d\d:\d\d$", t) and re.match(r"\w{3} [ \d]\d \d{4}$", d):
+            return d, t
+        i = data.find(struct.pack("<I", APP_DESC_MAGIC), i + 4)
+    return None
+
+
+def program_version(date, time):
+    """Same format as Version::Version(), YY.MMDD-HH."""
+    dt = datetime.strptime(f"{' '.join(date.split())} {time}", "%b %d %Y %H:%M:%S")
+    return f"{dt.year % 100:02d}.{dt.month:02d}{dt.day:02d}-{dt.hour:02d}"
+
+
+def find_elf(elf_dir, version, sha_prefix):
+    by_version = None
+    for path in sorted(glob.glob(os.path.join(elf_dir, "**", "*.elf"), recursive=True)):
+        if sha_prefix:
+            with open(path, "rb") as f:
+                if hashlib.sha256(f.read()).hexdigest().startswith(sha_prefix):
+                    return path
+        desc = elf_app_desc(path)
+        if version and desc and program_version(*desc) == version and not by_version:
+            by_version = path
+    return by_version
+
+
+def espcoredump():
+    idf = os.environ.get("IDF_PATH")
+    if idf:
+        script = os.path.join(idf, "components", "espcoredump", "espcoredump.py")
+        if os.path.exists(script):
+            return [sys.executable, script]
+    return ["espcoredump.py"]
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Fetch and analyse a coredump from the device")
+    parser.add_argument("host", nargs="?", default=os.environ.get("XCFLASH_HOST", "192.168.4.1"),
+                        help="device address, default $XCFLASH_HOST or the AP address")
+    parser.add_argument("--elf-dir", default="build", help="searched recursively for the matching ELF")
+    parser.add_argument("-o", "--output", default=".", help="directory for the fetched dump")
+    parser.add_argument("--no-info", action="store_true", help="only fetch and match, do not run espcoredump.py")
+    args = parser.parse_args()
+
+    try:
+        dump, sha, version = fetch(args.host)
+    except urllib.error.HTTPError as e:
+        sys.exit(f"No coredump on {args.host} ({e.code})")
+    if sha and hashlib.sha256(dump).hexdigest() != sha.lower():
+        sys.exit("Coredump SHA-256 mismatch, transfer broken")
+    core = os.path.join(args.output, f"xcflash-core-{version or 'unknown'}.bin")
+    with open(core, "wb") as f:
+        f.write(dump)
+    print(f"Fetched {len(dump)} bytes, version {version}: {core}")
+
+    sha_prefix = dump_elf_sha(dump)
+    elf = find_elf(args.elf_dir, version, sha_prefix)
+    if not elf:
+        sys.exit(f"No ELF for version {version} (ELF SHA-256 {sha_prefix or '?'}) in {args.elf_dir}")
+    print(f"Matching ELF: {elf}")
+    if not args.no_info:
+        sys.exit(subprocess.call(espcoredump() + ["info_corefile", "--core", core, "--core-format", "raw", elf]))
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+#
+# Creates a delta update: a patch turning the image running on the device
+# (old) into the new one, applied on the device by main/OtaDelta.cpp.
+# The device only accepts the patch if the old image is the one running,
+# see "running_sha256" in /status.json.
+#
+#   tools/ota_delta.py old/xcflash.bin build/xcflash.bin -o xcflash-delta.xcu
+#
+
+import argparse
+import hashlib
+import struct
+import zlib
+
+from ota_pack import WINDOW_BITS, header
+
+FORMAT_DELTA = 2
+K = 16           # min. match length to start a copy/add
+STRIDE = 4       # index every STRIDE'th position of the old image
+
+
+def image_sha256(image):
+    """Hash of an app image as esp_partition_get_sha256() reports it for the running partition."""
+    if len(image) > 24 + 32 and image[23] == 1:   # hash_appended in esp_image_header_t
+        return bytes(image[-32:])
+    return hashlib.sha256(image).digest()
+
+
+def diff(old, new):
+    """Operations as understood by OtaDelta, bsdiff like: an approximate match
+    is sent as difference to the old data, which is mostly zero and compresses well."""
+    index = {}
+    for i in range(0, len(old) - K + 1, STRIDE):
+        index.setdefault(old[i:i + K], i)
+
+    ops = bytearray()
+
+    def data(a, b):
+        if b > a:
+            ops.extend(b"D" + struct.pack("<I", b - a) + new[a:b])
+
+    def copy(off, j, n):
+        d = bytes((new[j + i] - old[off + i]) & 0xff for i in range(n))
+        if d.count(0) == n:
+            ops.extend(b"C" + struct.pack("<II", off, n))
+        else:
+            ops.extend(b"A" + struct.pack("<II", off, n) + d)
+
+    j = 0
+    literal = 0
+    lastoff = 0  # old - new position of the last match, code moves in blocks
+    while j < len(new):
+        off = -1
+        key = new[j:j + K]
+        if len(key) == K:
+            if 0 <= j + lastoff <= len(old) - K and old[j + lastoff:j + lastoff + K] == key:
+                off = j + lastoff
+            else:
+                off = index.get(key, -1)
+        if off < 0:
+            j += 1
+            continue
+        # extend backwards into the pending literal
+        while j > literal and off > 0 and old[off - 1] == new[j - 1]:
+            off -= 1
+            j -= 1
+        # extend forward as long as at least half of the bytes match
+        score = best = length = 0
+        i = 0
+        while off + i < len(old) and j + i < len(new):
+            if old[off + i] == new[j + i]:
+                score += 1
+            i += 1
+            if 2 * score - i > 2 * best - length:
+                best, length = score, i
+            elif i - length > 64:
+                break
+        data(literal, j)
+        copy(off, j, length)
+        lastoff = off - j
+        j += length
+        literal = j
+    data(literal, len(new))
+    return bytes(ops)
+
+
+def delta(old, new, window_bits=WINDOW_BITS):
+    c = zlib.compressobj(9, zlib.DEFLATED, window_bits, 9)
+    return header(FORMAT_DELTA, new) + image_sha256(old) + c.compress(diff(old, new)) + c.flush()
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Create a delta update against the running image")
+    parser.add_argument("old", help="app image running on the device")
+    parser.add_argument("new", help="new app image")
+    parser.add_argument("-o", "--output", default="xcflash-delta.xcu")
+    args = parser.parse_args()
+
+    with open(args.old, "rb") as f:
+        old = f.read()
+    with open(args.new, "rb") as f:
+        new = f.read()
+    patch = delta(old, new)
+    with open(args.output, "wb") as f:
+        f.write(patch)
+    print(f"Delta {args.old} > {args.new}: {len(new)} > {len(patch)} bytes {args.output}")
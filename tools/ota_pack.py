@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+#
+# Packs an app image for the web update: zlib compressed with a window the
+# device can inflate with (OTA_INFLATE_WINDOW_BITS in main/OtaDecoder.h),
+# behind a t_ota_header carrying size and SHA-256 of the image.
+#
+#   tools/ota_pack.py build/xcflash.bin              -> build/xcflash.xcu
+#
+
+import argparse
+import hashlib
+import struct
+import zlib
+
+MAGIC = b"XCU1"
+FORMAT_ZLIB = 1
+WINDOW_BITS = 13    # must not exceed OTA_INFLATE_WINDOW_BITS
+
+
+def header(fmt, image):
+    return struct.pack("<4sB3xI32s", MAGIC, fmt, len(image), hashlib.sha256(image).digest())
+
+
+def pack(image, window_bits=WINDOW_BITS):
+    c = zlib.compressobj(9, zlib.DEFLATED, window_bits, 9)
+    return header(FORMAT_ZLIB, image) + c.compress(image) + c.flush()
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Pack an app image for compressed OTA")
+    parser.add_argument("image", help="app image, e.g. build/xcflash.bin")
+    parser.add_argument("-o", "--output", help="packed image, default <image>.xcu")
+    parser.add_argument("--window-bits", type=int, default=WINDOW_BITS, choices=range(9, WINDOW_BITS + 1),
+                        help="deflate window, the device inflates up to %d bits" % WINDOW_BITS)
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+    packed = pack(image, args.window_bits)
+    output = args.output or args.image.rsplit(".", 1)[0] + ".xcu"
+    with open(output, "wb") as f:
+        f.write(packed)
+    print(f"Packed {args.image}: {len(image)} > {len(packed)} bytes ({100 * len(packed) // len(image)}%) {output}")
@@ -0,0 +1,40 @@
+/*
+ * Arduino.h for host builds (tools/test): just what AdaptUGC and the
+ * screen code use.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "freertos/FreeRTOS.h"
+
+#define PROGMEM
+#define SPI_MODE0 0
+#define MSBFIRST 1
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+void delay( uint32_t ms );
+
+class Print {
+public:
+	virtual ~Print() {}
+	virtual size_t write( uint8_t c ) = 0;
+	virtual size_t write( const uint8_t *buffer, size_t size ) = 0;
+	size_t print( const char *s ) { return write( (const uint8_t *)s, strlen( s ) ); }
+	size_t printf( const char *format, ... ) __attribute__ ((format (printf, 2, 3))) {
+		char buf[128];
+		va_list arg;
+		va_start( arg, format );
+		int len = vsnprintf( buf, sizeof(buf), format, arg );
+		va_end( arg );
+		if( len < 0 )
+			return 0;
+		return write( (const uint8_t *)buf, strlen( buf ) );
+	}
+};
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stddef.h>
+
+typedef void *httpd_handle_t;
+typedef struct httpd_req httpd_req_t;
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+#endif
+void esp_restart( void );
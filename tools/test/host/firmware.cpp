@@ -0,0 +1,46 @@
+/*
+ * firmware.cpp
+ *
+ * The parts of the firmware the screen code links against but that are not
+ * built for the host: settings with their defaults, no NVS, no traffic list,
+ * no SPI bus.
+ */
+
+#include "SetupNG.h"
+#include "Traffic.h"
+#include "esp32_ili9341.h"
+#include <unistd.h>
+
+std::vector<SetupCommon *> *SetupCommon::instances = 0;
+
+SetupCommon::SetupCommon() {
+	if( !instances )
+		instances = new std::vector<SetupCommon *>;
+}
+
+SetupCommon::~SetupCommon() {
+}
+
+void SetupNotify::notify( SetupCommon *item, const void *oldval, const void *newval, size_t valsize ){
+}
+
+ESP32NVS *ESP32NVS::Instance = 0;
+ESP32NVS::ESP32NVS(){}
+bool ESP32NVS::commit(){ return true; }
+bool ESP32NVS::setBlob( const char *key, void *object, size_t length ){ return true; }
+bool ESP32NVS::erase( const char *key ){ return true; }
+bool ESP32NVS::getBlob( const char *key, void *object, size_t *length ){ return false; }
+
+SetupNG<int> alt_unit( "ALT_UNIT", ALT_UNIT_METER );
+SetupNG<int> dst_unit( "DST_UNIT", DST_UNIT_KM );
+SetupNG<int> display_orientation( "DISPLAY_ORIENT", DISPLAY_NORMAL );
+
+void Traffic::update( const nmea_pflaa_s &pflaa ){}
+void Traffic::tick(){}
+
+xSemaphoreHandle spiMutex = xSemaphoreCreateMutex();
+hal_t esp32_ili9341 = {};
+
+void delay( uint32_t ms ){
+	usleep( ms * 1000 );
+}
@@ -0,0 +1,131 @@
+/*
+ * freertos.cpp
+ *
+ * FreeRTOS tasks, semaphores and task notifications on POSIX threads for
+ * the host builds in tools/test.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+struct host_semaphore {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	unsigned count;
+};
+
+struct host_task {
+	void (*task)( void * );
+	void *arg;
+	pthread_t thread;
+	host_semaphore notify;
+};
+
+static SemaphoreHandle_t create( unsigned count ){
+	host_semaphore *s = new host_semaphore;
+	pthread_mutex_init( &s->mutex, nullptr );
+	pthread_cond_init( &s->cond, nullptr );
+	s->count = count;
+	return s;
+}
+
+// waits until count is nonzero or the ticks passed, mutex held
+static void waitCount( host_semaphore *s, TickType_t ticks ){
+	if( ticks == portMAX_DELAY ){
+		while( !s->count )
+			pthread_cond_wait( &s->cond, &s->mutex );
+		return;
+	}
+	struct timespec until;
+	clock_gettime( CLOCK_REALTIME, &until );
+	uint64_t ns = until.tv_nsec + (uint64_t)ticks * portTICK_PERIOD_MS * 1000000;
+	until.tv_sec += ns / 1000000000;
+	until.tv_nsec = ns % 1000000000;
+	while( !s->count && ticks )
+		if( pthread_cond_timedwait( &s->cond, &s->mutex, &until ) )
+			break;
+}
+
+static __thread host_task *current = nullptr;
+
+static void *run( void *arg ){
+	current = (host_task *)arg;
+	current->task( current->arg );
+	return nullptr;
+}
+
+extern "C" {
+
+SemaphoreHandle_t xSemaphoreCreateMutex( void ){
+	return create( 1 );
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary( void ){
+	return create( 0 );
+}
+
+BaseType_t xSemaphoreTake( SemaphoreHandle_t s, TickType_t ticks ){
+	pthread_mutex_lock( &s->mutex );
+	waitCount( s, ticks );
+	bool taken = s->count > 0;
+	if( taken )
+		s->count--;
+	pthread_mutex_unlock( &s->mutex );
+	return taken ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive( SemaphoreHandle_t s ){
+	pthread_mutex_lock( &s->mutex );
+	bool given = s->count == 0;   // binary and mutex, never above one
+	s->count = 1;
+	pthread_cond_signal( &s->cond );
+	pthread_mutex_unlock( &s->mutex );
+	return given ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xTaskCreatePinnedToCore( void (*task)(void *), const char *name, uint32_t stack, void *arg,
+		UBaseType_t prio, TaskHandle_t *handle, BaseType_t core ){
+	host_task *t = new host_task;
+	t->task = task;
+	t->arg = arg;
+	pthread_mutex_init( &t->notify.mutex, nullptr );
+	pthread_cond_init( &t->notify.cond, nullptr );
+	t->notify.count = 0;
+	if( handle )
+		*handle = t;
+	if( pthread_create( &t->thread, nullptr, run, t ) )
+		return pdFALSE;
+	pthread_detach( t->thread );
+	return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake( BaseType_t clear, TickType_t ticks ){
+	host_semaphore *n = &current->notify;
+	pthread_mutex_lock( &n->mutex );
+	waitCount( n, ticks );
+	uint32_t count = n->count;
+	if( clear )
+		n->count = 0;
+	else if( count )
+		n->count--;
+	pthread_mutex_unlock( &n->mutex );
+	return count;
+}
+
+BaseType_t xTaskNotifyGive( TaskHandle_t task ){
+	pthread_mutex_lock( &task->notify.mutex );
+	task->notify.count++;
+	pthread_cond_signal( &task->notify.cond );
+	pthread_mutex_unlock( &task->notify.mutex );
+	return pdPASS;
+}
+
+void vTaskDelay( TickType_t ticks ){
+	usleep( ticks * 1000 * portTICK_PERIOD_MS );
+}
+
+}
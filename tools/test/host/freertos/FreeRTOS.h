@@ -0,0 +1,41 @@
+/*
+ * The few FreeRTOS calls the display code uses, on POSIX threads
+ * (tools/test/host/freertos.cpp).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef struct host_task *TaskHandle_t;
+typedef struct host_semaphore *SemaphoreHandle_t;
+typedef SemaphoreHandle_t xSemaphoreHandle;
+typedef void *QueueHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define portMAX_DELAY      0xffffffffUL
+#define portTICK_PERIOD_MS 1
+#define pdTRUE             1
+#define pdFALSE            0
+#define pdPASS             1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BaseType_t xTaskCreatePinnedToCore( void (*task)(void *), const char *name, uint32_t stack, void *arg,
+		UBaseType_t prio, TaskHandle_t *handle, BaseType_t core );
+void vTaskDelay( TickType_t ticks );
+uint32_t ulTaskNotifyTake( BaseType_t clear, TickType_t ticks );
+BaseType_t xTaskNotifyGive( TaskHandle_t task );
+
+SemaphoreHandle_t xSemaphoreCreateMutex( void );
+SemaphoreHandle_t xSemaphoreCreateBinary( void );
+BaseType_t xSemaphoreTake( SemaphoreHandle_t s, TickType_t ticks );
+BaseType_t xSemaphoreGive( SemaphoreHandle_t s );
+
+#ifdef __cplusplus
+}
+#endif
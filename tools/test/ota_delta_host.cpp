@@ -0,0 +1,67 @@
+/*
+ * ota_delta_host.cpp
+ *
+ * Host driver for main/OtaDelta.cpp, used by test_ota_delta.py:
+ *
+ *   ota_delta_host <old image> <patch operations> <new image> [piece size]
+ *
+ * Feeds the patch in pieces of the given size like the OTA writer does.
+ */
+
+#include "OtaDelta.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static std::vector<uint8_t> source;
+static FILE *out;
+
+static int writeOut( const uint8_t *data, size_t len ){
+	return fwrite( data, 1, len, out ) == len ? 0 : -10;
+}
+
+static int readSource( size_t offset, uint8_t *data, size_t len ){
+	if( offset + len > source.size() )
+		return -11;
+	std::copy( source.begin() + offset, source.begin() + offset + len, data );
+	return 0;
+}
+
+static std::vector<uint8_t> readFile( const char *name ){
+	std::vector<uint8_t> v;
+	FILE *f = fopen( name, "rb" );
+	if( !f ){
+		perror( name );
+		exit( 2 );
+	}
+	int c;
+	while( (c = fgetc( f )) != EOF )
+		v.push_back( c );
+	fclose( f );
+	return v;
+}
+
+int main( int argc, char **argv ){
+	if( argc < 4 ){
+		fprintf( stderr, "usage: %s old patch new [piece]\n", argv[0] );
+		return 2;
+	}
+	source = readFile( argv[1] );
+	std::vector<uint8_t> patch = readFile( argv[2] );
+	size_t piece = argc > 4 ? atoi( argv[4] ) : 4096;
+	out = fopen( argv[3], "wb" );
+	OtaDelta::begin( writeOut, readSource, source.size() );
+	for( size_t p=0; p<patch.size(); p+=piece ){
+		int err = OtaDelta::feed( &patch[p], std::min( piece, patch.size()-p ) );
+		if( err ){
+			fprintf( stderr, "patch error %d at %u\n", err, (unsigned)p );
+			return 1;
+		}
+	}
+	fclose( out );
+	if( !OtaDelta::complete() ){
+		fprintf( stderr, "patch truncated\n" );
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,441 @@
+/*
+ * screens_host.cpp
+ *
+ * Host driver for the display code, used by test_screens.py:
+ *
+ *   screens_host <output dir> [retained|framebuffer|banded]
+ *
+ * AdaptUGC and the real ILI9341 display driver send to an emulated panel
+ * instead of the SPI bus. The ops_* screens are drawn with plain eglib calls,
+ * directly or, in framebuffer mode, into a frame buffer flushed with
+ * eglib_FrameBuffer_SendUpdated(), in banded mode with
+ * eglib_FrameBuffer_Render() into 40 row bands. In these two modes the
+ * tga_* screens are the same frame buffer on eglib's tga display, they
+ * have no bus statistics. The panel decodes column/row address, memory
+ * write, inversion and scrolling commands into its
+ * frame memory. After each screen update the visible image is written as
+ * <output dir>/<screen>.ppm and one line of statistics is printed:
+ *
+ *   <screen> calls <n> pixels <n> bytes <n> wire_us <n> cpu_us <n>
+ *
+ * calls: display driver operations (chip select cycles), pixels: pixels
+ * written to frame memory, bytes: everything on the bus, wire_us: bytes at
+ * the board's SPI clock, cpu_us: host time to render.
+ */
+
+#include "AdaptUGC.h"
+#include "Flarm.h"
+extern "C" {
+#include <eglib/display/ili9341.h>
+#include <eglib/display/frame_buffer.h>
+#include <eglib/display/tga.h>
+#include <eglib/hal/four_wire_spi/none.h>
+#include <eglib/drawing/fonts/adobe.h>
+}
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#define PANEL_W          240
+#define PANEL_H          320
+#define PANEL_ROW_OFFSET 34           // ili9341.c shifts rows for the glass
+#define PANEL_ROWS       (PANEL_H + 2 * PANEL_ROW_OFFSET)
+#define SPI_HZ           (13111111*3) // as in AdaptUGC.cpp
+#define OPS_BAND         40
+#define OPS_BOX          12
+
+class Panel {
+public:
+	uint32_t calls = 0, pixels = 0, bytes = 0;
+
+	void reset(){ calls = pixels = bytes = 0; }
+
+	void begin(){ calls++; }
+
+	void send( enum hal_dc_t dc, const uint8_t *b, uint32_t len ){
+		bytes += len;
+		for( uint32_t i=0; i<len; i++ ){
+			if( dc == HAL_COMMAND )
+				command( b[i] );
+			else
+				data( b[i] );
+		}
+	}
+
+	// visible image, RGB. The glass is wired BGR, the BGR bit the driver sets
+	// in memory access control compensates that, so pixels show as sent.
+	void save( const char *path ){
+		FILE *f = fopen( path, "wb" );
+		if( !f ){
+			perror( path );
+			exit( 2 );
+		}
+		fprintf( f, "P6\n%d %d\n255\n", PANEL_W, PANEL_H );
+		for( int y=0; y<PANEL_H; y++ ){
+			int row = scrolled( y + PANEL_ROW_OFFSET );
+			for( int x=0; x<PANEL_W; x++ ){
+				uint16_t v = gram[row][x];
+				int r = v >> 11, g = (v >> 5) & 0x3f, b = v & 0x1f;
+				uint8_t rgb[3] = { (uint8_t)(r << 3 | r >> 2), (uint8_t)(g << 2 | g >> 4), (uint8_t)(b << 3 | b >> 2) };
+				if( inverted )
+					for( int i=0; i<3; i++ )
+						rgb[i] = ~rgb[i];
+				fwrite( rgb, 1, 3, f );
+			}
+		}
+		fclose( f );
+	}
+
+private:
+	uint16_t gram[PANEL_ROWS][PANEL_W] = {};
+	uint8_t cmd = 0;
+	uint8_t args[8];
+	int nargs = 0;
+	int xs = 0, xe = PANEL_W-1, ys = 0, ye = PANEL_ROWS-1;
+	int cx = 0, cy = 0;
+	uint8_t pixel[2];
+	int npixel = 0;
+	bool inverted = false;
+	int top = 0, middle = PANEL_ROWS, vsp = 0;
+
+	static uint16_t word( const uint8_t *a ){ return a[0] << 8 | a[1]; }
+
+	void command( uint8_t c ){
+		cmd = c;
+		nargs = 0;
+		npixel = 0;
+		switch( c ){
+		case 0x20: inverted = false; break;
+		case 0x21: inverted = true; break;
+		case 0x2c: cx = xs; cy = ys; break;
+		}
+	}
+
+	void data( uint8_t d ){
+		if( cmd == 0x2c ){
+			pixel[npixel++] = d;
+			if( npixel == 2 ){
+				write( word( pixel ) );
+				npixel = 0;
+			}
+			return;
+		}
+		if( nargs < (int)sizeof(args) )
+			args[nargs++] = d;
+		switch( cmd ){
+		case 0x2a: if( nargs == 4 ){ xs = word( args ); xe = word( args+2 ); } break;
+		case 0x2b: if( nargs == 4 ){ ys = word( args ); ye = word( args+2 ); } break;
+		case 0x33: if( nargs == 6 ){ top = word( args ); middle = word( args+2 ); } break;
+		case 0x37: if( nargs == 2 ) vsp = word( args ); break;
+		}
+	}
+
+	void write( uint16_t v ){
+		if( cx < PANEL_W && cy < PANEL_ROWS ){
+			gram[cy][cx] = v;
+			pixels++;
+		}
+		if( ++cx > xe ){
+			cx = xs;
+			if( ++cy > ye )
+				cy = ys;
+		}
+	}
+
+	// frame memory row shown on a panel line, vertical scrolling moves the middle area
+	int scrolled( int line ){
+		if( line < top || line >= top + middle || middle <= 0 )
+			return line;
+		return top + (line - top + vsp - top + middle) % middle;
+	}
+};
+
+static Panel panel;
+
+static void hal_init( eglib_t *eglib ){}
+static void hal_sleep( eglib_t *eglib ){}
+static void hal_delay_ns( eglib_t *eglib, uint32_t ns ){}
+static void hal_set_reset( eglib_t *eglib, bool state ){}
+static bool hal_get_busy( eglib_t *eglib ){ return false; }
+static void hal_comm_begin( eglib_t *eglib ){ panel.begin(); }
+static void hal_comm_end( eglib_t *eglib ){}
+
+static void hal_send( eglib_t *eglib, enum hal_dc_t dc, uint8_t *bytes, uint32_t length ){
+	panel.send( dc, bytes, length );
+}
+
+static void hal_send_repeat( eglib_t *eglib, enum hal_dc_t dc, uint8_t *bytes, uint32_t length, uint32_t count ){
+	while( count-- )
+		panel.send( dc, bytes, length );
+}
+
+static const hal_t panel_hal = {
+	.init = hal_init,
+	.sleep_in = hal_sleep,
+	.sleep_out = hal_sleep,
+	.delay_ns = hal_delay_ns,
+	.set_reset = hal_set_reset,
+	.get_busy = hal_get_busy,
+	.comm_begin = hal_comm_begin,
+	.send = hal_send,
+	.comm_end = hal_comm_end,
+	.send_repeat = hal_send_repeat,
+};
+
+static ili9341_config_t panel_config = {
+	.width = PANEL_W,
+	.height = PANEL_H,
+	.color = ILI9341_COLOR_16_BIT,
+	.page_address = ILI9341_PAGE_ADDRESS_TOP_TO_BOTTOM,
+	.colum_address = ILI9341_COLUMN_ADDRESS_LEFT_TO_RIGHT,
+	.page_column_order = ILI9341_PAGE_COLUMN_ORDER_NORMAL,
+	.vertical_refresh = ILI9341_VERTICAL_REFRESH_TOP_TO_BOTTOM,
+	.horizontal_refresh = ILI9341_HORIZONTAL_REFRESH_LEFT_TO_RIGHT,
+};
+
+static tga_config_t tga_config = {
+	.width = PANEL_W,
+	.height = PANEL_H,
+};
+
+static AdaptUGC ucg;
+static const char *outdir;
+static bool tgaScreen;  // screen() saves the tga image instead of the panel
+
+// tga rows are stored bottom up, blue first
+static void saveTga( const char *path ){
+	FILE *f = fopen( path, "wb" );
+	if( !f ){
+		perror( path );
+		exit( 2 );
+	}
+	fprintf( f, "P6\n%d %d\n255\n", PANEL_W, PANEL_H );
+	for( int y=PANEL_H-1; y>=0; y-- ){
+		for( int x=0; x<PANEL_W; x++ ){
+			const uint8_t *p = tga_config.tga_data + ( y * PANEL_W + x ) * 3;
+			uint8_t rgb[3] = { p[2], p[1], p[0] };
+			fwrite( rgb, 1, 3, f );
+		}
+	}
+	fclose( f );
+}
+
+static double now_us(){
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// one screen update, drawn by draw()
+static void screen( const char *name, void (*draw)() ){
+	panel.reset();
+	double t = now_us();
+	draw();
+	ucg.sync();
+	t = now_us() - t;
+	char path[256];
+	snprintf( path, sizeof(path), "%s/%s.ppm", outdir, name );
+	if( tgaScreen )
+		saveTga( path );
+	else
+		panel.save( path );
+	printf( "%s calls %u pixels %u bytes %u wire_us %u cpu_us %u\n", name, panel.calls, panel.pixels, panel.bytes,
+			(unsigned)( (uint64_t)panel.bytes * 8 * 1000000 / SPI_HZ ), (unsigned)t );
+}
+
+static void pflau( int level, int bearing, int vertical, int distance ){
+	char s[80];
+	snprintf( s, sizeof(s), "$PFLAU,3,1,2,1,%d,%d,2,%d,%d,DD8F12*", level, bearing, vertical, distance );
+	snprintf( s + strlen(s), sizeof(s) - strlen(s), "%02X", Flarm::calcNMEACheckSum( s ) );
+	Flarm::parsePFLAU( s );
+}
+
+static void flarmInit(){
+	ucg.clearScreen();
+	Flarm::initFlarmWarning();
+}
+
+static void flarmAlarm(){
+	pflau( 2, -30, 50, 820 );
+	Flarm::drawFlarmWarning();
+}
+
+static void flarmMove(){
+	pflau( 3, 45, -20, 360 );
+	Flarm::drawFlarmWarning();
+}
+
+static void flarmSame(){
+	Flarm::drawFlarmWarning();
+}
+
+static void downloadInfo(){
+	ucg.clearScreen();
+	Flarm::drawDownloadInfo();
+}
+
+enum ops_mode_t { OPS_DIRECT, OPS_FRAMEBUFFER, OPS_BANDED };
+
+static eglib_t opsEglib;
+static frame_buffer_config_t opsBuffer;
+static ops_mode_t opsMode = OPS_DIRECT;
+static uint32_t seed;
+
+static int rnd( int n ){
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) % n;
+}
+
+// 300 pseudo random drawing operations of every kind, some reaching off screen
+static void opsDraw( eglib_t *eglib ){
+	coordinate_t w = eglib_GetWidth( eglib ), h = eglib_GetHeight( eglib );
+	seed = 1;
+	eglib_undoClipRange( eglib );
+	eglib_SetIndexColor( eglib, 0, 0, 0, 0 );
+	eglib_ClearScreen( eglib );
+	eglib_SetFont( eglib, &font_Adobe_HelveticaBold_12px );
+	for( int i=0; i<300; i++ ){
+		eglib_SetIndexColor( eglib, 0, rnd(256), rnd(256), rnd(256) );
+		eglib_SetIndexColor( eglib, 1, rnd(256), rnd(256), rnd(256) );
+		coordinate_t x = rnd( w+40 ) - 20, y = rnd( h+40 ) - 20;
+		switch( rnd(8) ){
+		case 0: eglib_DrawPixel( eglib, x, y ); break;
+		case 1: eglib_DrawLine( eglib, x, y, rnd( w+40 ) - 20, rnd( h+40 ) - 20 ); break;
+		case 2: eglib_DrawBox( eglib, x, y, rnd(60) + 1, rnd(60) + 1 ); break;
+		case 3: eglib_DrawFrame( eglib, x, y, rnd(60) + 1, rnd(60) + 1 ); break;
+		case 4: eglib_DrawDisc( eglib, x, y, rnd(30) + 1, EGLIB_DRAW_ALL ); break;
+		case 5: eglib_DrawCircle( eglib, x, y, rnd(30) + 1, EGLIB_DRAW_ALL ); break;
+		case 6:
+			eglib_setFilledMode( eglib, rnd(2) );
+			eglib_DrawText( eglib, x, y, "FLARM 1.2km" );
+			break;
+		case 7:
+			if( rnd(2) )
+				eglib_setClipRange( eglib, x, y, rnd(120) + 1, rnd(120) + 1 );
+			else
+				eglib_undoClipRange( eglib );
+			break;
+		}
+	}
+	eglib_undoClipRange( eglib );
+}
+
+// two small changes in opposite corners, at x[i], y[i]
+static void opsBoxes( eglib_t *eglib, coordinate_t x[2], coordinate_t y[2] ){
+	x[0] = y[0] = 4;
+	x[1] = eglib_GetWidth( eglib ) - OPS_BOX - 4;
+	y[1] = eglib_GetHeight( eglib ) - OPS_BOX - 4;
+}
+
+static void opsChange( eglib_t *eglib ){
+	coordinate_t x[2], y[2];
+	opsBoxes( eglib, x, y );
+	eglib_SetIndexColor( eglib, 0, 255, 255, 0 );
+	eglib_DrawBox( eglib, x[0], y[0], OPS_BOX, OPS_BOX );
+	eglib_SetIndexColor( eglib, 0, 0, 255, 255 );
+	eglib_DrawBox( eglib, x[1], y[1], OPS_BOX, OPS_BOX );
+}
+
+static void opsRenderFrame( eglib_t *eglib, void *arg ){
+	opsDraw( eglib );
+}
+
+static void opsRenderUpdate( eglib_t *eglib, void *arg ){
+	opsDraw( eglib );
+	opsChange( eglib );
+}
+
+static void opsFrame(){
+	switch( opsMode ){
+	case OPS_DIRECT:
+		opsDraw( &opsEglib );
+		break;
+	case OPS_FRAMEBUFFER:
+		opsDraw( &opsEglib );
+		eglib_FrameBuffer_SendUpdated( &opsEglib );
+		break;
+	case OPS_BANDED:
+		eglib_FrameBuffer_Render( &opsEglib, 0, 0, eglib_GetWidth( &opsEglib ), eglib_GetHeight( &opsEglib ),
+				opsRenderFrame, nullptr );
+		break;
+	}
+}
+
+// banded, the whole frame is drawn again but only the two windows are sent
+static void opsUpdate(){
+	coordinate_t x[2], y[2];
+	switch( opsMode ){
+	case OPS_DIRECT:
+		opsChange( &opsEglib );
+		break;
+	case OPS_FRAMEBUFFER:
+		opsChange( &opsEglib );
+		eglib_FrameBuffer_SendUpdated( &opsEglib );
+		break;
+	case OPS_BANDED:
+		opsBoxes( &opsEglib, x, y );
+		for( int i=0; i<2; i++ )
+			eglib_FrameBuffer_Render( &opsEglib, x[i], y[i], OPS_BOX, OPS_BOX, opsRenderUpdate, nullptr );
+		break;
+	}
+}
+
+static void opsInit( const hal_t *hal, const display_t *display, void *config ){
+	switch( opsMode ){
+	case OPS_DIRECT:
+		eglib_Init( &opsEglib, hal, nullptr, display, config );
+		break;
+	case OPS_FRAMEBUFFER:
+		eglib_Init_FrameBuffer( &opsEglib, &opsBuffer, hal, nullptr, display, config );
+		break;
+	case OPS_BANDED:
+		eglib_Init_FrameBuffer_Banded( &opsEglib, &opsBuffer, OPS_BAND, hal, nullptr, display, config );
+		break;
+	}
+}
+
+static void opsDone(){
+	if( opsMode != OPS_DIRECT )
+		frame_buffer_Free( &opsEglib );
+}
+
+int main( int argc, char *argv[] ){
+	if( argc < 2 ){
+		fprintf( stderr, "usage: %s <output dir> [retained|framebuffer|banded]\n", argv[0] );
+		return 2;
+	}
+	outdir = argv[1];
+	bool retained = argc > 2 && !strcmp( argv[2], "retained" );
+	if( argc > 2 && !strcmp( argv[2], "framebuffer" ) )
+		opsMode = OPS_FRAMEBUFFER;
+	if( argc > 2 && !strcmp( argv[2], "banded" ) )
+		opsMode = OPS_BANDED;
+	ucg.setRedBlueTwist( true );
+	ucg.invertDisplay( true );
+	ucg.begin( &panel_hal, nullptr, &ili9341, &panel_config, retained );
+	Flarm::setDisplay( &ucg );
+
+	if( opsMode == OPS_DIRECT ){
+		screen( "flarm_init", flarmInit );
+		screen( "flarm_alarm", flarmAlarm );
+		screen( "flarm_move", flarmMove );
+		screen( "flarm_same", flarmSame );
+		screen( "download_info", downloadInfo );
+	}
+	if( retained )
+		return 0;
+	opsInit( &panel_hal, &ili9341, &panel_config );
+	screen( "ops_frame", opsFrame );
+	screen( "ops_update", opsUpdate );
+	opsDone();
+	if( opsMode == OPS_DIRECT )
+		return 0;
+
+	tgaScreen = true;
+	opsInit( &four_wire_spi_none, &tga, &tga_config );
+	screen( "tga_frame", opsFrame );
+	screen( "tga_update", opsUpdate );
+	opsDone();
+	return 0;
+}
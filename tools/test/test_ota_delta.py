@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+#
+# Round trip test for delta updates on Linux: tools/ota_delta.py creates
+# patches, main/OtaDelta.cpp built for the host applies them.
+#
+#   pytest tools/test   or   python3 tools/test/test_ota_delta.py
+#
+
+import hashlib
+import os
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(HERE, ".."))
+
+import ota_delta  # noqa: E402
+from ota_pack import MAGIC  # noqa: E402
+
+MAIN = os.path.join(HERE, "..", "..", "main")
+HEADER = struct.calcsize("<4sB3xI32s")
+
+
+def build(tmp):
+    exe = os.path.join(tmp, "ota_delta_host")
+    subprocess.check_call(["g++", "-std=gnu++11", "-O2", "-Wall", "-I", MAIN, "-o", exe,
+                           os.path.join(HERE, "ota_delta_host.cpp"), os.path.join(MAIN, "OtaDelta.cpp")])
+    return exe
+
+
+def fake_image(rnd, size):
+    """Something code like: repeated instruction patterns with 32 bit addresses."""
+    img = bytearray(b"\xe9" + bytes(23))
+    words = [rnd.getrandbits(32) for _ in range(64)]
+    while len(img) < size:
+        if rnd.random() < 0.7:
+            img += struct.pack("<I", rnd.choice(words))
+        else:
+            img += struct.pack("<I", 0x40080000 + rnd.getrandbits(16))
+    return bytes(img[:size])
+
+
+def mutate(rnd, old):
+    new = bytearray(old)
+    for _ in range(20):
+        pos = rnd.randrange(len(new))
+        kind = rnd.choice(("insert", "delete", "change", "shift"))
+        if kind == "insert":
+            new[pos:pos] = rnd.randbytes(rnd.randrange(1, 2000))
+        elif kind == "delete":
+            del new[pos:pos + rnd.randrange(1, 2000)]
+        elif kind == "change":
+            new[pos:pos + 4] = rnd.randbytes(4)
+        else:
+            # relocated code: all addresses in a range move
+            for i in range(pos & ~3, min(len(new) - 4, pos + 4096), 4):
+                w = struct.unpack_from("<I", new, i)[0]
+                if w & 0xfff00000 == 0x40000000:
+                    struct.pack_into("<I", new, i, w + 0x40)
+    return bytes(new)
+
+
+def apply(exe, tmp, old, patch, piece):
+    """Parses the container as OtaDecoder does and applies the operations on the host."""
+    assert patch[:4] == MAGIC and patch[4] == ota_delta.FORMAT_DELTA
+    size, sha = struct.unpack_from("<I32s", patch, 8)
+    assert patch[HEADER:HEADER + 32] == ota_delta.image_sha256(old)
+    d = zlib.decompressobj(ota_delta.WINDOW_BITS)   # fails if the window is too big
+    ops = d.decompress(patch[HEADER + 32:]) + d.flush()
+    files = [os.path.join(tmp, n) for n in ("old.bin", "ops.bin", "new.bin")]
+    for name, data in zip(files, (old, ops)):
+        with open(name, "wb") as f:
+            f.write(data)
+    subprocess.check_call([exe] + files + [str(piece)])
+    with open(files[2], "rb") as f:
+        new = f.read()
+    assert len(new) == size and hashlib.sha256(new).digest() == sha
+    return new
+
+
+def test_round_trip():
+    rnd = random.Random(42)
+    with tempfile.TemporaryDirectory() as tmp:
+        exe = build(tmp)
+        for n in range(4):
+            old = fake_image(rnd, rnd.randrange(50000, 300000))
+            new = mutate(rnd, old)
+            patch = ota_delta.delta(old, new)
+            assert apply(exe, tmp, old, patch, rnd.choice((1, 7, 4096))) == new
+            assert len(patch) < len(new) // 4
+
+
+def test_unrelated_images():
+    rnd = random.Random(7)
+    with tempfile.TemporaryDirectory() as tmp:
+        exe = build(tmp)
+        old = rnd.randbytes(20000)
+        new = rnd.randbytes(30000)
+        assert apply(exe, tmp, old, ota_delta.delta(old, new), 1000) == new
+        assert apply(exe, tmp, old, ota_delta.delta(old, b""), 1000) == b""
+
+
+if __name__ == "__main__":
+    test_round_trip()
+    test_unrelated_images()
+    print("OK")
@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+#
+# Screen rendering test on Linux: main/AdaptUGC.cpp, main/Flarm.cpp and the
+# eglib ILI9341 driver built for the host draw into an emulated panel
+# (screens_host.cpp). Every screen must match its reference image in
+# tools/test/screens/, drawn directly and through the retained display list.
+# The ops_* screens, plain eglib drawing, must come out the same through the
+# eglib frame buffer, which only sends what changed, and rendered band by band.
+# The tga_* screens are these frame buffers on eglib's tga display instead.
+#
+#   pytest tools/test   or   python3 tools/test/test_screens.py [--bench]
+#
+# UPDATE_EXPECTATIONS=1 rewrites the reference images after an intended change.
+# --bench prints bus traffic and render time per screen for both modes.
+#
+
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.join(HERE, "..", "..")
+MAIN = os.path.join(ROOT, "main")
+EGLIB = os.path.join(ROOT, "components", "eglib")
+SHIMS = os.path.join(HERE, "host")
+FRAME_BUFFER_MERGE_PIXELS = 64  # frame_buffer.h
+EXPECTED = os.path.join(HERE, "screens")
+
+# fonts AdaptUGC maps the u8g2 fonts to, the FreeFont ones are generated
+FREEFONT = {
+    "FreeMonoBold": (15, 20),
+    "FreeSans": (20,),
+    "FreeSansBold": (18, 20, 24, 28, 32, 48, 66),
+}
+FREEFONT_BLOCKS = ["BasicLatin", "32", "126", "Latin1Supplement", "161", "255",
+                   "LatinExtendedA", "256", "382", "SuperscriptsAndSubscripts", "8304", "8351"]
+
+EGLIB_SOURCES = ["eglib.c", "eglib/display.c", "eglib/drawing.c", "eglib/hal.c", "eglib/display/ili9341.c",
+                 "eglib/display/frame_buffer.c", "eglib/display/tga.c", "eglib/hal/four_wire_spi/none.c",
+                 "eglib/drawing/fonts/adobe/helvetica_bold.c",
+                 "eglib/drawing/fonts/adobe/new_century_schoolbook_roman.c"]
+MAIN_SOURCES = ["AdaptUGC.cpp", "DisplayList.cpp", "Flarm.cpp"]
+HOST_SOURCES = ["screens_host.cpp", "host/firmware.cpp", "host/freertos.cpp"]
+
+
+def pkg_config(*args):
+    return subprocess.check_output(["pkg-config"] + list(args + ("freetype2",))).decode().split()
+
+
+def generate_fonts(tmp):
+    generator = os.path.join(tmp, "font_generator")
+    subprocess.check_call(["gcc", "-O2"] + pkg_config("--cflags") +
+                          ["-o", generator, os.path.join(EGLIB, "font_generator", "font_generator.c")] +
+                          pkg_config("--libs"))
+    sources = []
+    for family, sizes in FREEFONT.items():
+        c_file = os.path.join(tmp, family + ".c")
+        with open(c_file, "w") as f:
+            f.write("#include <eglib/drawing.h>\n")
+            f.flush()
+            for size in sizes:
+                subprocess.check_call([generator, os.path.join(EGLIB, "fonts", "freefont-20120503", family + ".ttf"),
+                                       "FreeFont_%s_%dpx" % (family, size), "0", str(size)] + FREEFONT_BLOCKS,
+                                      stdout=f)
+        sources.append(c_file)
+    return sources
+
+
+def build(tmp):
+    includes = ["-I", SHIMS, "-I", MAIN, "-I", EGLIB, "-I", os.path.join(EGLIB, "eglib"),
+                "-I", os.path.join(EGLIB, "eglib", "hal", "four_wire_spi", "esp32")]
+    objects = []
+    for src in generate_fonts(tmp) + [os.path.join(EGLIB, s) for s in EGLIB_SOURCES]:
+        obj = os.path.join(tmp, "%d.o" % len(objects))
+        subprocess.check_call(["gcc", "-std=gnu11", "-O2", "-c", "-o", obj] + includes + [src])
+        objects.append(obj)
+    exe = os.path.join(tmp, "screens_host")
+    subprocess.check_call(["g++", "-std=gnu++11", "-O2", "-Wno-format", "-o", exe] + includes +
+                          [os.path.join(MAIN, s) for s in MAIN_SOURCES] +
+                          [os.path.join(HERE, s) for s in HOST_SOURCES] + objects + ["-lpthread"])
+    return exe
+
+
+def render(exe, tmp, mode):
+    """Draws all screens, returns {screen: (width, height, rgb)} and {screen: statistics}."""
+    out = os.path.join(tmp, mode)
+    os.makedirs(out, exist_ok=True)
+    lines = subprocess.check_output([exe, out, mode]).decode().splitlines()
+    images, stats = {}, {}
+    for line in lines:
+        name, *fields = line.split()
+        stats[name] = {k: int(v) for k, v in zip(fields[::2], fields[1::2])}
+        images[name] = read_ppm(os.path.join(out, name + ".ppm"))
+    return images, stats
+
+
+def read_ppm(path):
+    with open(path, "rb") as f:
+        magic, width, height, _ = f.readline().split() + f.readline().split() + f.readline().split()
+        assert magic == b"P6"
+        return int(width), int(height), f.read()
+
+
+def write_png(path, image):
+    width, height, rgb = image
+    rows = b"".join(b"\0" + rgb[y * width * 3:(y + 1) * width * 3] for y in range(height))
+
+    def chunk(kind, data):
+        return struct.pack(">I", len(data)) + kind + data + struct.pack(">I", zlib.crc32(kind + data))
+
+    with open(path, "wb") as f:
+        f.write(b"\x89PNG\r\n\x1a\n" + chunk(b"IHDR", struct.pack(">IIBBBBB", width, height, 8, 2, 0, 0, 0)) +
+                chunk(b"IDAT", zlib.compress(rows, 9)) + chunk(b"IEND", b""))
+
+
+def read_png(path):
+    """8 bit RGB, as written by write_png()."""
+    with open(path, "rb") as f:
+        png = f.read()
+    pos, idat = 8, b""
+    while pos < len(png):
+        length, kind = struct.unpack_from(">I4s", png, pos)
+        data = png[pos + 8:pos + 8 + length]
+        if kind == b"IHDR":
+            width, height, depth, color = struct.unpack_from(">IIBB", data)
+            assert depth == 8 and color == 2
+        elif kind == b"IDAT":
+            idat += data
+        pos += 12 + length
+    raw, stride = zlib.decompress(idat), width * 3
+    rgb, prev = bytearray(), bytearray(stride)
+    for y in range(height):
+        kind, row = raw[y * (stride + 1)], bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for i in range(stride):
+            a = row[i - 3] if i >= 3 else 0
+            b, c = prev[i], prev[i - 3] if i >= 3 else 0
+            if kind == 1:
+                row[i] = (row[i] + a) & 0xff
+            elif kind == 2:
+                row[i] = (row[i] + b) & 0xff
+            elif kind == 3:
+                row[i] = (row[i] + (a + b) // 2) & 0xff
+            elif kind == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                row[i] = (row[i] + (a if pa <= pb and pa <= pc else b if pb <= pc else c)) & 0xff
+        rgb += row
+        prev = row
+    return width, height, bytes(rgb)
+
+
+def as_panel(image):
+    """24 bit image as the panel shows it: RGB565, inverted by the ILI9341 driver."""
+    width, height, rgb = image
+    five = bytes(~((v >> 3) << 3 | v >> 5) & 0xff for v in range(256))
+    six = bytes(~((v >> 2) << 2 | v >> 6) & 0xff for v in range(256))
+    panel = bytearray(len(rgb))
+    panel[0::3], panel[1::3], panel[2::3] = rgb[0::3].translate(five), rgb[1::3].translate(six), \
+        rgb[2::3].translate(five)
+    return width, height, bytes(panel)
+
+
+def differing_pixels(a, b):
+    if a[:2] != b[:2]:
+        return a[0] * a[1]
+    return sum(a[2][i:i + 3] != b[2][i:i + 3] for i in range(0, len(a[2]), 3))
+
+
+def check(images):
+    update = os.environ.get("UPDATE_EXPECTATIONS")
+    for name, image in images.items():
+        path = os.path.join(EXPECTED, name + ".png")
+        if update:
+            os.makedirs(EXPECTED, exist_ok=True)
+            write_png(path, image)
+            continue
+        assert os.path.exists(path), "no reference image %s, run with UPDATE_EXPECTATIONS=1" % path
+        diff = differing_pixels(image, read_png(path))
+        assert diff == 0, "%s: %d pixels differ from %s" % (name, diff, path)
+
+
+def test_screens():
+    with tempfile.TemporaryDirectory() as tmp:
+        exe = build(tmp)
+        direct, _ = render(exe, tmp, "direct")
+        check(direct)
+        retained, _ = render(exe, tmp, "retained")
+        for name in retained:
+            assert direct[name] == retained[name], "%s: retained drawing differs from direct" % name
+        buffered, stats = render(exe, tmp, "framebuffer")
+        for name in buffered:
+            assert direct[name] == buffered[name] if name in direct else \
+                direct[name.replace("tga_", "ops_")] == as_panel(buffered[name]), \
+                "%s: frame buffer drawing differs from direct" % name
+        # two 12x12 boxes in opposite corners go out as two small windows, not the screen between them
+        assert stats["ops_update"]["pixels"] <= 2 * 12 * 12 + FRAME_BUFFER_MERGE_PIXELS, stats["ops_update"]
+        banded, stats = render(exe, tmp, "banded")
+        for name in banded:
+            assert direct[name] == banded[name] if name in direct else \
+                direct[name.replace("tga_", "ops_")] == as_panel(banded[name]), \
+                "%s: banded drawing differs from direct" % name
+        assert stats["ops_update"]["pixels"] == 2 * 12 * 12, stats["ops_update"]
+
+
+def bench():
+    with tempfile.TemporaryDirectory() as tmp:
+        exe = build(tmp)
+        print("%-16s %-11s %7s %8s %8s %8s %8s" % ("screen", "mode", "calls", "pixels", "bytes", "wire_us", "cpu_us"))
+        for mode in ("direct", "retained", "framebuffer", "banded"):
+            for name, s in render(exe, tmp, mode)[1].items():
+                print("%-16s %-11s %7d %8d %8d %8d %8d" % (name, mode, s["calls"], s["pixels"], s["bytes"],
+                                                           s["wire_us"], s["cpu_us"]))
+
+
+if __name__ == "__main__":
+    if "--bench" in sys.argv:
+        bench()
+    else:
+        test_screens()
+        print("OK")